@@ -0,0 +1,28 @@
+#ifndef EDGE_ORDER_HPP
+#define EDGE_ORDER_HPP
+
+#include <vector>
+
+#include <OverlapGraph.hpp>
+#include <Utils.hpp>
+
+/** Edges of every node ranked by descending metric, computed once per metric
+ * and aligned with the graph adjacency. Edges with equal metric keep their
+ * load order. The graph must not be loaded into while the order is used. */
+class EdgeOrder {
+public:
+    EdgeOrder(const OverlapGraph &g, Utils::Metrics metric);
+
+    /** Returns the edges of the node, best first. Every entry is the first
+     * edge in load order leading to the same neighbour as the ranked one,
+     * which is the edge a path takes when it chooses that neighbour. */
+    const OverlapGraph::Edge *const *ranked(const OverlapGraph::Node &n) const {
+        return ranked_.data() + offsets_[n.index];
+    }
+
+private:
+    const std::vector<ulong> &offsets_;
+    std::vector<const OverlapGraph::Edge *> ranked_;
+};
+
+#endif
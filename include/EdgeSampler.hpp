@@ -0,0 +1,56 @@
+#ifndef EDGE_SAMPLER_HPP
+#define EDGE_SAMPLER_HPP
+
+#include <vector>
+
+#include <OverlapGraph.hpp>
+#include <RandomStream.hpp>
+#include <Utils.hpp>
+#include <VisitedSet.hpp>
+
+/** Draws an edge of a node with probability proportional to its metric, in
+ * constant time, through an alias table per node. Tables are aligned with
+ * the graph adjacency and built once per metric, the graph must not be
+ * loaded into while the sampler is used. Edges leading to visited nodes are
+ * rejected and drawn again. When that keeps failing, the edge is picked by a
+ * scan over the unvisited edges, so the distribution is the same as if the
+ * weights of the unvisited edges were summed and searched. Samples can be
+ * drawn from several threads at once. */
+class EdgeSampler {
+public:
+    /** Draws rejected before falling back to the scan. */
+    static constexpr int MAX_REJECTIONS = 16;
+
+    EdgeSampler(const OverlapGraph &g, Utils::Metrics metric);
+
+    /**
+     * Selects an edge of the node leading to a node that is not visited.
+     * @param n Node to leave.
+     * @param visited Visited nodes.
+     * @param gen Random number generator.
+     * @param scans Incremented if the edge was selected by the scan. Owned by
+     * the caller, so threads don't share a counter.
+     * @return Selected edge, or nullptr if all neighbours are visited.
+     */
+    const OverlapGraph::Edge *sample(const OverlapGraph::Node &n, const VisitedSet &visited,
+                                     RandomStream &gen, ulong &scans) const;
+
+private:
+    const OverlapGraph &g_;
+    /** Metric of every edge, aligned with the adjacency. */
+    std::vector<float> weight_;
+    /** Probability of keeping the drawn edge, aligned with the adjacency. */
+    std::vector<float> prob_;
+    /** Edge taken otherwise, relative to the first edge of the node. */
+    std::vector<uint> alias_;
+    /** True if the node has an edge with positive weight. Other nodes are
+     * always scanned. */
+    std::vector<bool> weighted_;
+
+    /** Draws from the unvisited edges of the node by summing their weights.
+     * Returns nullptr if there are none. */
+    const OverlapGraph::Edge *scan(const OverlapGraph::Node &n, const VisitedSet &visited,
+                                   RandomStream &gen) const;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef GRAPH_CACHE_HPP
+#define GRAPH_CACHE_HPP
+
+#include <vector>
+
+#include <MappedFile.hpp>
+#include <OverlapGraph.hpp>
+
+/** Binary snapshot of a filtered overlap graph. The file stores the filter
+ * parameters and a fingerprint of the input files it was built from, so a
+ * stale cache is detected and rebuilt instead of being used. */
+class GraphCache {
+public:
+    /** Computes a fingerprint from size and modification time of the files.
+     * @return false if any of the files cannot be accessed. */
+    static bool fingerprint(const std::vector<const char *> &filepaths, ulong &fingerprint);
+
+    /** Extends the fingerprint with given files, as if they followed the ones
+     * it was computed from. Used when overlap files are appended to a graph.
+     * @return false if any of the files cannot be accessed. */
+    static bool extendFingerprint(const std::vector<const char *> &filepaths, ulong &fingerprint);
+
+    /** Writes the graph to given file.
+     * @return false if an error occurred. */
+    static bool write(const OverlapGraph &g, const char *filepath, ulong fingerprint);
+
+    /** Replaces the graph with the one stored in given file. The cache is
+     * accepted only if it was built with the same fingerprint and the same
+     * filter parameters as the ones currently set in the graph.
+     * @return false if the cache is missing, stale or corrupted. */
+    static bool read(OverlapGraph &g, const char *filepath, ulong fingerprint);
+
+    /** Replaces the graph and its filter parameters with the ones stored in
+     * given file, regardless of the inputs it was built from. Used as the base
+     * that new overlap files are appended to.
+     * @param fingerprint Set to the fingerprint stored in the file.
+     * @return false if the file is missing or corrupted. */
+    static bool readSnapshot(OverlapGraph &g, const char *filepath, ulong &fingerprint);
+
+private:
+    /** Reads the graph sections that follow the header. */
+    static bool readGraph(OverlapGraph &g, const MappedFile &file);
+
+    /** Returns true if the length prefix and the characters of the name at
+     * given arena offset are inside the arena. */
+    static bool validName(const NameInterner &names, uint64_t offset);
+};
+
+#endif
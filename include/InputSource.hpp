@@ -0,0 +1,86 @@
+#ifndef INPUT_SOURCE_HPP
+#define INPUT_SOURCE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/** Sequential source of bytes that an overlap file is read from. Used for
+ * inputs that cannot be memory-mapped, like standard input, pipes and
+ * compressed files. */
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    /** Reads up to n bytes into buf. Blocks until at least one byte is
+     * available. Returns number of bytes read, 0 at the end of input and -1
+     * if an error occurred. */
+    virtual long read(char *buf, size_t n) = 0;
+
+    /** Opens the given path, "-" stands for standard input. Gzip input is
+     * decompressed while reading, BGZF input with up to given number of
+     * threads.
+     * @return nullptr if the path cannot be opened. */
+    static std::unique_ptr<InputSource> open(const char *filepath, unsigned threads = 1);
+
+    /** Returns true if the file starts with the gzip magic bytes. */
+    static bool isCompressed(const char *filepath);
+};
+
+/** Reads from a file descriptor. */
+class FileSource : public InputSource {
+private:
+    int fd_;
+    bool owned_; /**< Descriptor is closed on destruction. */
+    std::vector<char> pending_; /**< Bytes returned by unread(), read first. */
+public:
+    FileSource(int fd, bool owned) : fd_(fd), owned_(owned) {}
+
+    ~FileSource() override;
+
+    long read(char *buf, size_t n) override;
+
+    /** Puts the bytes back in front of the remaining input. Used to detect
+     * the format of a stream that cannot seek. */
+    void unread(const char *data, size_t n);
+};
+
+/** Decompresses gzip input, including files of several concatenated members. */
+class GzipSource : public InputSource {
+private:
+    struct Stream;
+
+    std::unique_ptr<InputSource> in_;
+    std::unique_ptr<Stream> stream_;
+    std::vector<char> input_;
+    bool eof_ = false;
+public:
+    explicit GzipSource(std::unique_ptr<InputSource> in);
+
+    ~GzipSource() override;
+
+    long read(char *buf, size_t n) override;
+};
+
+/** Decompresses BGZF input (blocked gzip, written by bgzip and samtools).
+ * Every block is an independent gzip member that stores its compressed size
+ * in the 'BC' extra field, so a batch of blocks is read at once and the
+ * blocks are inflated in parallel, then returned in file order. */
+class BgzfSource : public InputSource {
+private:
+    std::unique_ptr<InputSource> in_;
+    unsigned threads_;
+    std::vector<char> output_; /**< Decompressed batch. */
+    size_t position_ = 0; /**< Bytes of output_ already returned. */
+    bool eof_ = false;
+
+    /** Reads and decompresses the next batch of blocks into output_.
+     * Returns false if the input is not valid BGZF. */
+    bool fill();
+public:
+    BgzfSource(std::unique_ptr<InputSource> in, unsigned threads);
+
+    long read(char *buf, size_t n) override;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef LOAD_STATS_HPP
+#define LOAD_STATS_HPP
+
+#include <ostream>
+#include <string>
+#include <sys/types.h>
+
+/** Counters collected while loading an overlap file. */
+struct LoadStats {
+    /** Path of the loaded file, empty for totals over several files. */
+    std::string file;
+    ulong bytes = 0;
+    ulong lines = 0;
+    /** Edges and nodes added to the graph. */
+    ulong edges = 0, nodes = 0;
+
+    /** Wall time of the whole load, in seconds. */
+    double time = 0;
+    /** Time spent tokenizing and converting fields, filtering and building
+     * the graph. Parallel workers add up their own time, so with multiple
+     * threads the parts can exceed the wall time. */
+    double parse_time = 0, filter_time = 0, build_time = 0;
+    /** Time spent waiting for input from standard input or a pipe. */
+    double read_time = 0;
+
+    /** Rejected lines by reason. Each line counts for the first check it fails. */
+    ulong secondary_rejects = 0;
+    ulong self_rejects = 0;
+    ulong overlap_length_rejects = 0;
+    ulong overlap_percentage_rejects = 0;
+    ulong overhang_length_rejects = 0;
+    ulong overhang_percentage_rejects = 0;
+
+    /** Name lookups while building and how many found an existing node. */
+    ulong name_lookups = 0, name_hits = 0;
+
+    /** Lines rejected before any name lookup or allocation. */
+    ulong earlyRejects() const;
+
+    double linesPerSecond() const { return time > 0 ? lines / time : 0.0; }
+
+    double bytesPerSecond() const { return time > 0 ? bytes / time : 0.0; }
+
+    double nameHitRate() const { return name_lookups > 0 ? static_cast<double>(name_hits) / name_lookups : 0.0; }
+
+    /** Adds counters and times of other to these. */
+    void merge(const LoadStats &other);
+
+    /** Writes a human-readable summary. */
+    void toStream(std::ostream &s) const;
+
+    /** Writes the counters as a JSON object. */
+    void toJson(std::ostream &s) const;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+
+/** Read-only memory mapping of a whole file. The mapping is released when the
+ * object is destroyed, so views into data() must not outlive it. */
+class MappedFile {
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    bool valid_ = false;
+public:
+    /** Maps the given file into memory. Check valid() for success. */
+    explicit MappedFile(const char *filepath);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /** Returns true if the file was opened and mapped. */
+    bool valid() const { return valid_; }
+
+    /** Returns pointer to the first byte of the file (nullptr if empty). */
+    const char *data() const { return data_; }
+
+    /** Returns the file size in bytes. */
+    size_t size() const { return size_; }
+};
+
+#endif
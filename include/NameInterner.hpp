@@ -0,0 +1,68 @@
+#ifndef NAME_INTERNER_HPP
+#define NAME_INTERNER_HPP
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <string_view>
+#include <vector>
+
+/** Maps sequence names to consecutive ids. Names are stored once in a single
+ * contiguous arena and looked up through an open-addressing hash table with
+ * linear probing. Ids are assigned in insertion order starting from 0. */
+class NameInterner {
+public:
+    /** Returned by find() when the name has not been interned. */
+    static constexpr uint NOT_FOUND = UINT_MAX;
+
+    /** Longest name that fits the 32-bit length prefix in the arena. */
+    static constexpr size_t MAX_NAME_LENGTH = UINT32_MAX;
+
+    /** Returns id of the name or NOT_FOUND if it is not interned. */
+    uint find(std::string_view name) const;
+
+    /** Returns id of the name, interning it under the next free id if it is
+     * not present yet. Sets inserted to true if the name was added. Name
+     * must not be longer than MAX_NAME_LENGTH. */
+    uint intern(std::string_view name, bool &inserted);
+
+    /** Returns arena offset of the name with given id. */
+    uint64_t offset(uint id) const { return offsets_[id]; }
+
+    /** Returns the name stored at given arena offset. */
+    std::string_view name(uint64_t offset) const;
+
+    /** Returns number of interned names. */
+    size_t size() const { return offsets_.size(); }
+
+    /** Returns number of bytes used by the arena. */
+    size_t arenaSize() const { return arena_.size(); }
+
+private:
+    friend class GraphCache;
+
+    struct Slot {
+        uint hash; /**< Name hash, compared before the name itself. */
+        uint id;   /**< Name id, NOT_FOUND if slot is empty. */
+    };
+
+    /** Hash table, capacity is always a power of two. */
+    std::vector<Slot> slots_;
+    /** Names, each stored as 32-bit length followed by its characters. */
+    std::vector<char> arena_;
+    /** Arena offset of each name, indexed by id. 64-bit so an arena larger
+     * than 4 GiB keeps its names apart. */
+    std::vector<uint64_t> offsets_;
+
+    static uint hash(std::string_view name);
+
+    /** Returns index of the slot holding the name or the empty slot where it
+     * should be inserted. Table must not be full. */
+    size_t probe(std::string_view name, uint h) const;
+
+    /** Doubles the table capacity and reinserts all ids. */
+    void grow();
+};
+
+#endif
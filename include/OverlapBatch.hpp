@@ -0,0 +1,81 @@
+#ifndef OVERLAP_BATCH_HPP
+#define OVERLAP_BATCH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <OverlapGraph.hpp>
+
+/** Batch of parsed PAF records whose filter columns are additionally stored
+ * as structure of arrays, so FilterParameters can be evaluated for several
+ * records at once with SIMD. Records keep views into the parsed buffer, the
+ * batch must be evaluated and cleared before that buffer changes. */
+class OverlapBatch {
+public:
+    /** Number of records in a full batch. */
+    static constexpr size_t CAPACITY = 4096;
+
+    enum Kernel {
+        /** One record at a time through OverlapGraph::filter() */
+        SCALAR,
+        /** 4 records per step */
+        SSE2,
+        /** 8 records per step */
+        AVX2
+    };
+
+    /** Returns true if the kernel can run on this CPU. */
+    static bool supported(Kernel kernel);
+
+    /** Returns the fastest kernel supported by this CPU. */
+    static Kernel best();
+
+    std::vector<OverlapGraph::PAFOverlap> records_;
+
+    OverlapBatch();
+
+    void push(const OverlapGraph::PAFOverlap &o);
+
+    bool full() const { return records_.size() == CAPACITY; }
+
+    bool empty() const { return records_.empty(); }
+
+    size_t size() const { return records_.size(); }
+
+    void clear();
+
+    /** Evaluates the graph's filter parameters for every record, with the
+     * fastest supported kernel. Results, including the reported reject
+     * reasons, are identical to OverlapGraph::filter().
+     * @return Number of records that passed. */
+    size_t evaluate(const OverlapGraph &g);
+
+    /** Same as evaluate() but runs the given kernel, which must be supported. */
+    size_t evaluate(const OverlapGraph &g, Kernel kernel);
+
+    /** Returns number of records the last evaluation rejected for given reason. */
+    size_t rejected(OverlapGraph::FilterResult reason) const { return reject_counts_[reason]; }
+
+    /** Returns true if the record passed the last evaluation. */
+    bool passed(size_t i) const { return (mask_[i / 64] >> (i % 64)) & 1; }
+
+    /** Calls f with every record that passed the last evaluation, in order. */
+    template<typename F>
+    void forEachPassed(F &&f) const {
+        for (size_t w = 0; w < mask_.size(); w++) {
+            for (uint64_t bits = mask_[w]; bits; bits &= bits - 1) {
+                f(records_[w * 64 + __builtin_ctzll(bits)]);
+            }
+        }
+    }
+
+private:
+    std::vector<int32_t> query_len_, query_start_, query_end_;
+    std::vector<int32_t> target_len_, target_start_, target_end_;
+    std::vector<uint64_t> mask_; /**< Bit per record, set if it passed. */
+    /** Bit per record for each check, set if the record failed it. Indexed by FilterResult. */
+    std::vector<uint64_t> failed_[OverlapGraph::HIGH_OVERHANG_PERCENTAGE + 1];
+    size_t reject_counts_[OverlapGraph::HIGH_OVERHANG_PERCENTAGE + 1] = {};
+};
+
+#endif
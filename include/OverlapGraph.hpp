@@ -1,37 +1,51 @@
 #ifndef OVERLAP_GRAPH_HPP
 #define OVERLAP_GRAPH_HPP
 
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <utility>
+
+#include <LoadStats.hpp>
+#include <NameInterner.hpp>
+#include <PAFTags.hpp>
 
 enum class ContigPosition : char;
 
+class OverlapBatch;
+
 class OverlapGraph {
 public:
     struct Edge;
 
+    /** Fields read while walking paths. Cold metadata, like the sequence
+     * name, is kept outside of the node and looked up by index. Edges of the
+     * node are in the adjacency, see edges(). */
     struct Node {
-        bool anchor; /**< True if node is anchor (contig). */
         uint index; /**< Unique node ID. Equal to position in vector of nodes. */
-        std::vector<Edge> edges; /**< Edges that connect to this node. */
         uint length; /**< Length of sequence. */
-        std::string name; /**< Unique sequence (node) name. */
+        bool anchor; /**< True if node is anchor (contig). */
+        bool touches_anchor = false; /**< True if an edge of the node leads to an anchor. */
 
-        Node(bool anchor, uint index, uint length, const std::string &name);
+        Node(bool anchor, uint index, uint length);
 
         bool operator==(const Node &) const;
 
-        void to_stream(std::ostream &) const;
+        void to_stream(std::ostream &, const OverlapGraph &) const;
     };
 
+    /** Edge record, stored twice per overlap in the adjacency, so it is kept
+     * compact. The node an edge is stored at is its target, so only the
+     * query index is kept. Scores used as path metrics stay full floats.
+     * Sequence identity is only reported, so it is stored as 15-bit fixed
+     * point and shares its 16 bits with the strand. */
     struct Edge {
-        uint q_index; /**< Index of first node of the edge in nodes_. */
-        uint t_index; /**< Index of second node of the edge in nodes_. */
+        uint q_index; /**< Index of the node the edge leads to in nodes_. */
         uint q_start, q_end, t_start, t_end;
-        float overlap_score, sequence_identity, extension_score;
-        bool relative_strand;
+        float overlap_score, extension_score;
 
-        Edge(uint q_index, uint t_index, uint q_start, uint q_end, uint t_start, uint t_end,
+        Edge(uint q_index, uint q_start, uint q_end, uint t_start, uint t_end,
              float overlap_score, float sequence_identity,
              float extension_score, bool relative_strand);
 
@@ -39,18 +53,45 @@ public:
 
         Edge &operator=(Edge &&) noexcept;
 
+        /** Returns the sequence identity, within 1 / 32767 of the parsed one. */
+        float sequenceIdentity() const { return static_cast<float>(identity_ & IDENTITY_MASK) / IDENTITY_MASK; }
+
+        /** Returns true if query and target are on different strands. */
+        bool relativeStrand() const { return (identity_ & STRAND_BIT) != 0; }
+
+        /** Returns how much the edge adds to the length of a path it is followed by. */
+        long lengthContribution() const { return q_start - static_cast<long>(t_start); }
+
+        /** Returns the same overlap as seen from the query node, with query
+         * and target swapped. The edge leads back to t_index, the node this
+         * one is stored at. */
+        Edge reversed(uint t_index) const;
+
         void to_stream(std::ostream &) const;
+
+    private:
+        friend class GraphCache;
+
+        static constexpr uint16_t STRAND_BIT = 0x8000;
+        static constexpr uint16_t IDENTITY_MASK = 0x7fff;
+
+        /** Fixed point sequence identity in the low 15 bits, strand in the top one. */
+        uint16_t identity_;
     };
 
+    /** Single PAF record. Names are views into the buffer the record was
+     * parsed from and are only valid while that buffer is. */
     struct PAFOverlap {
-        std::string query_name;
+        std::string_view query_name;
         int query_len, query_start, query_end;
         char relative_strand;
-        std::string target_name;
+        std::string_view target_name;
         int target_len, target_start, target_end;
         int residue_matches_num;
         int alignment_block_len;
         int mapping_quality;
+        /** Optional columns, parsed only when a tag is requested. */
+        PAFTags tags;
     };
 
     enum LengthCalculationMode {
@@ -64,6 +105,26 @@ public:
         SUM
     };
 
+    /** Outcome of the filter. Rejected overlaps report the first check they fail. */
+    enum FilterResult {
+        ACCEPTED,
+        /** Overlap is shorter than the minimum overlap length */
+        SHORT_OVERLAP,
+        /** Overlap covers less than the minimum overlap percentage */
+        LOW_OVERLAP_PERCENTAGE,
+        /** Overhang is longer than the maximum overhang length */
+        LONG_OVERHANG,
+        /** Overhang exceeds the maximum overhang percentage */
+        HIGH_OVERHANG_PERCENTAGE
+    };
+
+    enum LoaderMode {
+        /** Whitespace-separated fields are read through std::fstream */
+        ISTREAM,
+        /** File is memory-mapped and fields are tokenized in place */
+        MMAP
+    };
+
     struct FilterParameters {
         /** Mode of length calculation */
         LengthCalculationMode mode;
@@ -75,35 +136,211 @@ public:
         ulong max_overhang_length;
         /** Maximum allowed overhang length, as percentage of overlap length */
         float max_overhang_percentage;
+        /** Reject secondary alignments (tp:A:S) before their fields are converted */
+        bool skip_secondary = false;
+    };
+
+    /** Contiguous range of edges in the adjacency. */
+    class EdgeRange {
+    private:
+        const Edge *begin_, *end_;
+    public:
+        EdgeRange(const Edge *begin, const Edge *end) : begin_(begin), end_(end) {}
+
+        const Edge *begin() const { return begin_; }
+
+        const Edge *end() const { return end_; }
+
+        size_t size() const { return end_ - begin_; }
+
+        bool empty() const { return begin_ == end_; }
+
+        const Edge &operator[](size_t i) const { return begin_[i]; }
+    };
+
+    /** Contiguous range of positions in the adjacency. */
+    class SlotRange {
+    private:
+        const ulong *begin_, *end_;
+    public:
+        SlotRange(const ulong *begin, const ulong *end) : begin_(begin), end_(end) {}
+
+        const ulong *begin() const { return begin_; }
+
+        const ulong *end() const { return end_; }
+
+        size_t size() const { return end_ - begin_; }
+
+        bool empty() const { return begin_ == end_; }
     };
 
     std::vector<Node> nodes_;
-    std::vector<Edge> edges_;
+    /** Edges in compressed sparse row form. Every edge is stored once for
+     * each of its nodes, oriented so that the node is the target. Edges of
+     * node i are adjacency_[offsets_[i]] up to adjacency_[offsets_[i + 1]],
+     * in the order they were loaded. Built at the end of every load. */
+    std::vector<Edge> adjacency_;
+    std::vector<ulong> offsets_ = {0};
     FilterParameters filter_params_;
+    /** Node names, stored in a single arena. Name id is equal to the node
+     * index. */
+    NameInterner names_;
+
+    /** Returns the sequence name of the node. Used when printing and
+     * scaffolding, path construction never touches names. */
+    std::string_view name(const Node &n) const { return names_.name(names_.offset(n.index)); }
+
+    /** Returns edges connected to the node, each with the node as target.
+     * The range is invalidated by the next load. */
+    EdgeRange edges(const Node &n) const {
+        return {adjacency_.data() + offsets_[n.index], adjacency_.data() + offsets_[n.index + 1]};
+    }
+
+    /** Returns positions in the adjacency of the edges of the node that lead
+     * to an anchor, in load order. Empty unless touches_anchor is set. */
+    SlotRange anchorEdges(const Node &n) const {
+        return {anchor_slots_.data() + anchor_offsets_[n.index],
+                anchor_slots_.data() + anchor_offsets_[n.index + 1]};
+    }
+
+    /** Returns number of edges in the graph. */
+    size_t edgesNum() const { return adjacency_.size() / 2 + pending_.size(); }
 
     /**
      * Loads the given .paf file and constructs an overlap graph from it.
-     * @param filepath String path to the file.
+     * @param filepath String path to the file, "-" for standard input. Pipes
+     * are read while the producer is still writing to them. Gzip and BGZF
+     * compressed input is decompressed on the fly.
      * @param anchors The inputs will be anchors.
      * @return false if an error occurred.
      */
-    bool load(char *filepath, bool anchors);
+    bool load(const char *filepath, bool anchors);
+
+    /**
+     * Loads overlap files that are shards of one data set, like minimap2
+     * output split over cluster jobs. The graph is the same as if the shards
+     * were loaded one by one in the given order, but up to load_threads_
+     * shards are read, parsed and filtered at the same time, one per worker.
+     * Workers stay at most load_threads_ shards ahead of the merge, so a slow
+     * shard does not leave all later ones in memory.
+     * Accepted overlaps are added in shard order, so node indices don't
+     * depend on timing. Every shard gets its own entry in load_stats_.
+     * @return false if an error occurred.
+     */
+    bool load(const std::vector<std::string> &filepaths, bool anchors);
+
+    /** Expands a shard pattern into paths. A glob pattern gives the matching
+     * files in sorted order, "@file" the paths listed in the file, one per
+     * line, and anything else stands for itself.
+     * @return false if the pattern matches no file or the list cannot be read. */
+    static bool expandShards(const char *pattern, std::vector<std::string> &filepaths);
 
     /** Returns a string representation of the internal graph statistics. */
     std::string stats();
 
+    /** Returns graph and loader statistics as a JSON object. */
+    std::string statsJson() const;
+
+    /** Returns memory used by edge records in the adjacency, per edge of the
+     * graph. Every edge is stored twice. */
+    double bytesPerEdge() const;
+
+    /** Returns loader statistics summed over all loaded files. */
+    LoadStats loadStats() const;
+
     /** Variable used to specify the number of lines read from a file.
      * Used to cut down the loading time when testing.
      * By default, loads the whole file (is equal to 0).*/
     uint test_load_num_ = 0;
 
+    /** Method used to read the .paf files. */
+    LoaderMode loader_mode_ = MMAP;
+
+    /** Number of threads used to parse and filter a memory-mapped file, and
+     * to decompress BGZF input. */
+    uint load_threads_ = 1;
+
+    /** Loader statistics, one entry per loaded file. */
+    std::vector<LoadStats> load_stats_;
+
 private:
+    friend class GraphCache;
+    friend class OverlapBatch;
+
+    /** Edge that is not in the adjacency yet, with the node it is stored at. */
+    struct PendingEdge {
+        uint t_index;
+        Edge edge;
+    };
+
+    /** Edges added by the current load, not yet in the adjacency. */
+    std::vector<PendingEdge> pending_;
+
+    /** Adjacency positions of edges leading to anchors, grouped by node like
+     * the adjacency, see anchorEdges(). */
+    std::vector<ulong> anchor_slots_;
+    std::vector<ulong> anchor_offsets_ = {0};
+
+    /** Merges pending edges into the adjacency in place, without a second
+     * copy of it. Edges of every node keep their load order, new ones after
+     * the existing ones. */
+    void buildAdjacency();
+
+    /** Builds the adjacency after a load, adding the time to the entry of
+     * the last loaded file if the load succeeded. Returns ok. */
+    bool buildLoaded(bool ok);
+
+    /** Rebuilds the anchor edge index and touches_anchor from the adjacency. */
+    void buildAnchorIndex();
+
+    /** Parses and filters the file into pending_, see load(). Adds its
+     * entry to load_stats_. Returns false if an error occurred. */
+    bool loadFile(const char *filepath, bool anchors);
+
+    /** Reads the file through std::fstream. Returns false if an error occurred. */
+    bool loadStream(const char *filepath, bool anchors, LoadStats &stats);
+
+    /** Reads the file through a memory mapping. Returns false if an error occurred. */
+    bool loadMapped(const char *filepath, bool anchors, LoadStats &stats);
+
+    /** Reads the file incrementally through a bounded buffer. Used for
+     * standard input ("-"), pipes and gzip-compressed files. Returns false if
+     * an error occurred. */
+    bool loadBuffered(const char *filepath, bool anchors, LoadStats &stats);
+
+    /** Splits [begin, end) at line boundaries, parses and filters the chunks
+     * in parallel and merges accepted overlaps in file order. Returns pointer
+     * to the first malformed line, or nullptr on success. */
+    const char *loadChunks(const char *begin, const char *end, bool anchors, LoadStats &stats);
+
+    /** Overlaps accepted by the filter, with the position of the contig. */
+    using AcceptedOverlaps = std::vector<std::pair<PAFOverlap, ContigPosition>>;
+
+    /** Parses and filters [begin, end) without changing the graph, so several
+     * ranges can be processed concurrently. Accepted overlaps keep views into
+     * the range. Returns pointer to the first malformed line, or nullptr. */
+    const char *parseRange(const char *begin, const char *end, bool anchors, LoadStats &stats,
+                           AcceptedOverlaps &accepted) const;
+
+    /** Filters the batch and adds the usable overlaps to the graph in order,
+     * then clears the batch. */
+    void addBatch(OverlapBatch &batch, bool anchors, LoadStats &stats);
+
+    /**
+     * Filters the overlap and adds it to the graph if it is usable.
+     * @param overlap
+     * @param anchors The overlap comes from a contig-read file.
+     */
+    void add(const PAFOverlap &overlap, bool anchors, LoadStats &stats);
+
     /**
-     * Descides if the overlap is usable based on its quality.
+     * Descides if the overlap is usable based on its quality. Only the numeric
+     * columns are checked, so most lines are rejected before their names are
+     * compared or interned.
      * @param overlap
-     * @return true if given overlap is usable.
+     * @return ACCEPTED if given overlap is usable, otherwise the failed check.
      */
-    bool filter(const PAFOverlap &overlap) const;
+    FilterResult filter(const PAFOverlap &overlap) const;
 
     /**
      * Constructs and edge and nodes (if they don't exist) and adds them to the
@@ -112,15 +349,6 @@ private:
      * @param pos flag signaling if and where contigs is in the overlap.
      */
     void buildFrom(const PAFOverlap &overlap, ContigPosition pos);
-
-    /**
-     * Check if node has already been seen. More specifically, the function
-     * checks if node is present in internal node vector.
-     * @param n node to check if it is present.
-     * @return index of the node in internal vector if it is present in internal
-     * vectors. If it is not present, function returns -1.
-     */
-    long nodeIndex(const std::string &name) const;
 };
 
 enum class ContigPosition : char {
@@ -0,0 +1,47 @@
+#ifndef PAF_TAGS_HPP
+#define PAF_TAGS_HPP
+
+#include <string_view>
+
+/** View of the optional SAM-style columns (TAG:TYPE:VALUE) that follow the
+ * 12 mandatory PAF columns. Only the byte range is recorded while parsing,
+ * individual tags are located and converted on request. */
+class PAFTags {
+public:
+    /** Tab-separated optional columns, empty if the record has none. */
+    std::string_view raw_;
+
+    PAFTags() = default;
+
+    explicit PAFTags(std::string_view raw) : raw_(raw) {}
+
+    /** Finds the tag with given two-character key.
+     * @return false if the record doesn't contain the tag. */
+    bool find(std::string_view key, char &type, std::string_view &value) const;
+
+    /** Returns alignment type (tp), 'P' for primary, 'S' for secondary and
+     * 'I' or 'i' for inversions. Returns '\0' if the tag is missing. */
+    char type() const;
+
+    /** Returns true if the record is a secondary alignment (tp:A:S). */
+    bool secondary() const { return type() == 'S'; }
+
+    /** Number of minimizers on the chain (cm). */
+    bool minimizers(int &value) const { return getInt("cm", value); }
+
+    /** Chaining score (s1). */
+    bool chainScore(int &value) const { return getInt("s1", value); }
+
+    /** Approximate per-base sequence divergence (dv). */
+    bool divergence(float &value) const { return getFloat("dv", value); }
+
+    /** Reads an integer (i) tag.
+     * @return false if the tag is missing or has a different type. */
+    bool getInt(std::string_view key, int &value) const;
+
+    /** Reads a floating point (f) tag.
+     * @return false if the tag is missing or has a different type. */
+    bool getFloat(std::string_view key, float &value) const;
+};
+
+#endif
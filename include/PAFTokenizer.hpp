@@ -0,0 +1,39 @@
+#ifndef PAF_TOKENIZER_HPP
+#define PAF_TOKENIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/** Finds field and line delimiters (tabs and newlines) in a block of PAF
+ * text. The vector kernels compare 16 (SSE2) or 32 (AVX2) bytes at a time,
+ * the fastest one supported by the CPU is selected at runtime. */
+class PAFTokenizer {
+public:
+    enum Kernel {
+        /** Byte-by-byte comparison */
+        SCALAR,
+        /** 16 bytes per step */
+        SSE2,
+        /** 32 bytes per step */
+        AVX2
+    };
+
+    /** Returns true if the kernel can run on this CPU. */
+    static bool supported(Kernel kernel);
+
+    /** Returns the fastest kernel supported by this CPU. */
+    static Kernel best();
+
+    /**
+     * Writes offsets of all tabs and newlines in data[0, n) to out, in
+     * increasing order, using the fastest supported kernel.
+     * @param out Must have room for n offsets.
+     * @return Number of offsets written.
+     */
+    static size_t scan(const char *data, size_t n, uint32_t *out);
+
+    /** Same as scan() but runs the given kernel, which must be supported. */
+    static size_t scan(const char *data, size_t n, uint32_t *out, Kernel kernel);
+};
+
+#endif
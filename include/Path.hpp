@@ -6,13 +6,24 @@
 
 class Path {
 private:
-    long length_;
+    long length_ = 0;
 public:
     std::vector<const OverlapGraph::Node *> nodes_;
     std::vector<const OverlapGraph::Edge *> edges_;
 
+    /** Recomputes the length from all nodes and edges. Needed only after
+     * nodes_ or edges_ were changed directly. */
     void updateLength();
 
+    /** Starts an empty path at the given node. */
+    void start(const OverlapGraph::Node *node);
+
+    /** Appends an edge and the node it leads to, updating the length in constant time. */
+    void push(const OverlapGraph::Edge *edge, const OverlapGraph::Node *node);
+
+    /** Removes the last edge and node, updating the length in constant time. */
+    void pop();
+
     long length() const;
 
     friend std::ostream &operator<<(std::ostream &s, const Path &p);
@@ -7,11 +7,38 @@
 #include <OverlapGraph.hpp>
 #include <Path.hpp>
 #include <PathGroup.hpp>
+#include <RandomStream.hpp>
 #include <Utils.hpp>
+#include <VisitedSet.hpp>
+
+class EdgeOrder;
+class EdgeSampler;
 
 class PathManager {
 private:
     std::vector<Path> paths_;
+
+    /** Path builders instantiated for every metric, so the metric is read
+     * from the edge without a switch on every step. */
+    template<Utils::Metrics M>
+    void buildMonteCarlo(const OverlapGraph &g);
+
+    template<Utils::Metrics M>
+    void buildDeterministic(const OverlapGraph &g);
+
+    /** Builds one Monte Carlo path from the anchor into p. visited_nodes
+     * must be empty. Edges drawn by the sampler's scan are added to scans.
+     * Returns true if it reached another anchor. */
+    template<Utils::Metrics M>
+    bool walkMonteCarlo(const OverlapGraph &g, const EdgeSampler &sampler, const OverlapGraph::Node &start_node,
+                        RandomStream &gen, VisitedSet &visited_nodes, ulong &scans, Path &p) const;
+
+    /** Builds the deterministic path from the anchor through the first edge
+     * into path. visited_nodes must be empty. Returns true if the path
+     * reached another anchor and is usable. */
+    template<Utils::Metrics M>
+    bool walkDeterministic(const OverlapGraph &g, const EdgeOrder &order, const OverlapGraph::Node &start_node,
+                           const OverlapGraph::Edge &first_edge, VisitedSet &visited_nodes, Path &path) const;
 public:
     void buildMonteCarlo(const OverlapGraph &g, const Utils::Metrics &metric);
 
@@ -37,6 +64,11 @@ public:
         /** Valley and peak ratio needed for splitting the paths into groups
          * according to lowest path length frequency in the valley window. */
         float ratio_threshold;
+        /** Seed of the Monte Carlo random number streams. */
+        ulong seed = 0;
+        /** Number of threads building Monte Carlo paths. Paths are the same
+         * for any number of threads. */
+        uint threads = 1;
     };
 
     Parameters params_;
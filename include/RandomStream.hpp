@@ -0,0 +1,41 @@
+#ifndef RANDOM_STREAM_HPP
+#define RANDOM_STREAM_HPP
+
+#include <cstdint>
+#include <limits>
+#include <sys/types.h>
+
+/** SplitMix64 random number generator, usable with the standard
+ * distributions. Its state is a single word, so a separate stream can be
+ * started for every task in constant time. Streams with different ids start
+ * at unrelated points of the sequence. */
+class RandomStream {
+public:
+    using result_type = uint64_t;
+
+    /** Starts the stream of the given seed and (id, sub_id) pair. */
+    RandomStream(ulong seed, uint id, uint sub_id)
+            : state_(mix(mix(seed) ^ (static_cast<uint64_t>(id) << 32 | sub_id))) {}
+
+    static constexpr result_type min() { return 0; }
+
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        state_ += GOLDEN_GAMMA;
+        return mix(state_);
+    }
+
+private:
+    static constexpr uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ull;
+
+    uint64_t state_;
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+};
+
+#endif
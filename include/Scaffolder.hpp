@@ -11,10 +11,11 @@
 class Scaffolder {
 public:
     const Path &p_;
+    const OverlapGraph &g_;
     std::vector<std::string> names_;
     std::vector<std::string> sequences_;
 
-    explicit Scaffolder(const Path &p) : p_(p) {}
+    Scaffolder(const Path &p, const OverlapGraph &g) : p_(p), g_(g) {}
 
     /** Load names and sequences from given filename. */
     bool load(const char *filename);
@@ -25,7 +26,7 @@ public:
     std::string &reverse(std::string &);
     std::string reverse(std::string );
 
-    std::string &getSequenceFrom(const std::string &name);
+    std::string &getSequenceFrom(std::string_view name);
 
     /** Construct resulting sequence and write to file. */
     bool write(const char *filename);
@@ -0,0 +1,78 @@
+#ifndef TASK_SCHEDULER_HPP
+#define TASK_SCHEDULER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <sys/types.h>
+
+/** Runs tasks made of independent steps, like the rebuild attempts of an
+ * anchor, on several threads. Workers take whole tasks in order. Once none
+ * is left, an idle worker steals the upper half of the steps not yet started
+ * by the worker with most of them left, and can itself be stolen from. A few
+ * slow tasks therefore don't leave the other threads idle at the end. */
+class TaskScheduler {
+public:
+    /** Runs one step of a task on the given worker, 0 <= worker < threads. */
+    using Step = std::function<void(size_t task, uint step, uint worker)>;
+
+    /** Largest number of steps in a range. Larger tasks are split into
+     * parts of at most this many steps. */
+    static constexpr uint MAX_STEPS = (1u << 24) - 1;
+
+    explicit TaskScheduler(uint threads);
+
+    /** Runs steps[i] steps of every task i and returns when all are done.
+     * Each step runs exactly once, in no particular order. */
+    void run(const std::vector<uint> &steps, const Step &step);
+
+    /** Returns number of workers. */
+    uint threads() const { return threads_; }
+
+    /** Returns time every worker spent running steps in the last run(), in seconds. */
+    const std::vector<double> &busyTimes() const { return busy_; }
+
+    /** Returns number of ranges stolen in the last run(). */
+    ulong steals() const { return steals_; }
+
+private:
+    /** Steps a worker has claimed but not started, packed into one word so
+     * the owner and thieves can shrink it with a compare and swap: the first
+     * step in bits 40-63, the end in bits 16-39 and a tag in bits 0-15, which
+     * changes with every new range so a stale range is never taken. */
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> range{0};
+        /** Part the range belongs to, written only while the range is empty. */
+        std::atomic<size_t> task{0};
+    };
+
+    /** Steps of a task, from first on, that fit into one range. */
+    struct Part {
+        size_t task;
+        uint first;
+    };
+
+    uint threads_;
+    std::vector<double> busy_;
+    ulong steals_ = 0;
+
+    static uint64_t pack(uint first, uint end, uint tag) {
+        return static_cast<uint64_t>(first) << 40 | static_cast<uint64_t>(end) << 16 | (tag & 0xffff);
+    }
+
+    static uint first(uint64_t range) { return static_cast<uint>(range >> 40); }
+
+    static uint end(uint64_t range) { return static_cast<uint>(range >> 16) & MAX_STEPS; }
+
+    static uint tag(uint64_t range) { return static_cast<uint>(range) & 0xffff; }
+
+    /** Claims the next step of the worker's own range. Returns false if it is empty. */
+    static bool claim(Slot &slot, uint &step);
+
+    /** Moves the upper half of the largest range of another worker into the
+     * thief's slot. Returns false if all ranges are empty. */
+    static bool steal(std::vector<Slot> &slots, uint thief);
+};
+
+#endif
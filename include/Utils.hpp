@@ -2,10 +2,13 @@
 #define TELOMERI_UTILS_H
 
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <iostream>
+#include <type_traits>
 
 #include <OverlapGraph.hpp>
 
@@ -14,7 +17,7 @@ namespace Utils {
      * @param str String to check.
      * @param temp Template to check with.
      * @return true - if string starts with given template. */
-    static bool startsWithInsensitive(const std::string &str, const std::string &temp) {
+    static bool startsWithInsensitive(std::string_view str, std::string_view temp) {
         if (str.length() < temp.length()) {
             return false;
         }
@@ -40,6 +43,46 @@ namespace Utils {
         return true;
     }
 
+    /** Parses a non-negative integer command line value. Exits on error. */
+    static ulong tryParsePosNum(const char *s) {
+        try {
+            long v = std::stol(s);
+
+            if (v < 0) {
+                std::cerr << "Value must be positive: " << s << std::endl;
+                exit(1);
+            }
+
+            return static_cast<ulong>(v);
+        } catch (std::invalid_argument &e) {
+            std::cerr << "Invalid int value: " << s << std::endl;
+        } catch (std::out_of_range &e) {
+            std::cerr << "Provided value is outside of int range: " << s << std::endl;
+        }
+
+        exit(1);
+    }
+
+    /** Parses a percentage command line value in range [0.0, 1.0]. Exits on error. */
+    static float tryParsePerc(const char *s) {
+        try {
+            float v = std::stof(s);
+
+            if (v < 0.0f || v > 1.0f) {
+                std::cerr << "Value must be in range [0.0, 1.0]: " << s << std::endl;
+                exit(1);
+            }
+
+            return v;
+        } catch (std::invalid_argument &e) {
+            std::cerr << "Invalid float value: " << s << std::endl;
+        } catch (std::out_of_range &e) {
+            std::cerr << "Provided value is outside of float range: " << s << std::endl;
+        }
+
+        exit(1);
+    }
+
     enum class Metrics {
         EXTENSION_SCORE, OVERLAP_SCORE, EXTENSION_SCORE_SQRT, OVERLAP_SCORE_SQRT
     };
@@ -59,6 +102,41 @@ namespace Utils {
         }
     }
 
+    /** Same as getMetric(), with the metric fixed at compile time so path
+     * builders evaluate it without a branch. */
+    template<Metrics M>
+    inline float getMetric(const OverlapGraph::Edge &e) {
+        if constexpr (M == Metrics::EXTENSION_SCORE) {
+            return e.extension_score;
+        } else if constexpr (M == Metrics::EXTENSION_SCORE_SQRT) {
+            return std::sqrt(e.extension_score);
+        } else if constexpr (M == Metrics::OVERLAP_SCORE) {
+            return e.overlap_score;
+        } else {
+            return std::sqrt(e.overlap_score);
+        }
+    }
+
+    /** Calls f with the metric as std::integral_constant, so f can
+     * instantiate a template for it. */
+    template<typename F>
+    void dispatchMetric(Metrics metric, F &&f) {
+        switch (metric) {
+            case Metrics::EXTENSION_SCORE:
+                f(std::integral_constant<Metrics, Metrics::EXTENSION_SCORE>());
+                break;
+            case Metrics::EXTENSION_SCORE_SQRT:
+                f(std::integral_constant<Metrics, Metrics::EXTENSION_SCORE_SQRT>());
+                break;
+            case Metrics::OVERLAP_SCORE:
+                f(std::integral_constant<Metrics, Metrics::OVERLAP_SCORE>());
+                break;
+            case Metrics::OVERLAP_SCORE_SQRT:
+                f(std::integral_constant<Metrics, Metrics::OVERLAP_SCORE_SQRT>());
+                break;
+        }
+    }
+
     static char *getMetricName(const Utils::Metrics &metric) {
         switch (metric) {
             case Utils::Metrics::EXTENSION_SCORE:
@@ -0,0 +1,40 @@
+#ifndef VISITED_SET_HPP
+#define VISITED_SET_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/** Set of visited node indices that is cleared in constant time. Every node
+ * keeps the generation it was last visited in, and clear() starts a new
+ * generation, so a walker can reuse one set for all of its paths. */
+class VisitedSet {
+public:
+    explicit VisitedSet(size_t size = 0) : stamps_(size, 0) {}
+
+    /** Returns true if the node was visited since the last clear(). */
+    bool operator[](size_t i) const { return stamps_[i] == generation_; }
+
+    void insert(size_t i) { stamps_[i] = generation_; }
+
+    void erase(size_t i) { stamps_[i] = 0; }
+
+    /** Removes all nodes. Stamps are only rewritten when the generation
+     * counter wraps around, once every 65535 clears. */
+    void clear() {
+        if (++generation_ == 0) {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            generation_ = 1;
+        }
+    }
+
+    size_t size() const { return stamps_.size(); }
+
+private:
+    /** Generation of the last visit, 0 for never. Two bytes per node keep
+     * the set of a large graph small enough to stay in cache. */
+    std::vector<uint16_t> stamps_;
+    uint16_t generation_ = 1;
+};
+
+#endif
@@ -7,10 +7,12 @@
 #          L  rr_overlaps.paf
 #          L  cr_overlaps.paf
 
-if [ $# -ne 1 ]
+if [ $# -lt 1 -o $# -gt 2 ] || [ $# -eq 2 -a "$2" != "--stream" ]
 then
     echo "Please provide the dataset directory path!"
-    echo "Usage: ./run.sh <dataset-dir>"
+    echo "Usage: ./run.sh <dataset-dir> [--stream]"
+    echo "With --stream, overlaps are piped from minimap2 straight into Telomeri"
+    echo "without writing the overlap files."
     echo "Dataset structure must match the following"
     echo "<dataset-dir>"
     echo "       L  reads.fasta"
@@ -34,6 +36,16 @@ contigs_file=$dir/"contigs.fast?"
 rr_file=$dir/"rr_overlaps.paf"
 cr_file=$dir/"cr_overlaps.paf"
 
+# Stream overlaps from minimap2, no intermediate files.
+if [ "$2" = "--stream" ]
+then
+    ./Telomeri \
+        <(./minimap2/minimap2 --dual=yes -x ava-pb $reads_file $reads_file) \
+        <(./minimap2/minimap2 --dual=yes -x ava-pb $contigs_file $reads_file) \
+        $reads_file $contigs_file $out_file
+    exit $?
+fi
+
 # Construct overlaps if needed.
 if [ ! -f $rr_file -a ! -f $cr_file ]
 then
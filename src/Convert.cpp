@@ -0,0 +1,142 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <GraphCache.hpp>
+#include <Stopwatch.hpp>
+#include <Utils.hpp>
+
+/** Adds overlap files to an existing graph cache. Read-read files are loaded
+ * before contig-read files, in the order given, same as in Telomeri. */
+int append(OverlapGraph &graph, int argc, char **argv) {
+    const char *snapshot_file = argv[2];
+    const char *output_file = argv[argc - 1];
+    std::vector<const char *> rr_files, cr_files;
+    for (int i = 3; i < argc - 1; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc - 1;
+        if (arg == "--rr" && has_value) {
+            rr_files.push_back(argv[++i]);
+        } else if (arg == "--cr" && has_value) {
+            cr_files.push_back(argv[++i]);
+        } else if (arg == "--load-istream") {
+            graph.loader_mode_ = OverlapGraph::ISTREAM;
+        } else if (arg == "--threads" && has_value) {
+            graph.load_threads_ = std::max(1ul, Utils::tryParsePosNum(argv[++i]));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<const char *> files(rr_files);
+    files.insert(files.end(), cr_files.begin(), cr_files.end());
+    if (files.empty()) {
+        std::cerr << "No overlap files to append." << std::endl;
+        return 1;
+    }
+
+    Stopwatch timer;
+    timer.start();
+
+    std::cout << "Reading graph cache: " << snapshot_file << std::endl;
+    ulong fingerprint;
+    if (!GraphCache::readSnapshot(graph, snapshot_file, fingerprint)) {
+        std::cerr << "Cannot read graph cache: " << snapshot_file << std::endl;
+        return 1;
+    }
+    std::cout << "Done (" << timer.lap() << "s)" << std::endl;
+
+    if (!GraphCache::extendFingerprint(files, fingerprint)) {
+        std::cerr << "Cannot access overlap files." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Appending overlaps..." << std::endl;
+    if (!graph.load(std::vector<std::string>(rr_files.begin(), rr_files.end()), false)
+        || !graph.load(std::vector<std::string>(cr_files.begin(), cr_files.end()), true)) {
+        return 1;
+    }
+    std::cout << "Done (" << timer.lap() << "s)" << std::endl << graph.stats() << std::endl;
+
+    std::cout << "Writing graph cache: " << output_file << std::endl;
+    if (!GraphCache::write(graph, output_file, fingerprint)) {
+        std::cerr << "Cannot write file: " << output_file << std::endl;
+        return 1;
+    }
+    std::cout << "Done (" << timer.lap() << "s)" << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    OverlapGraph graph;
+    graph.filter_params_ = {
+            OverlapGraph::AVG,
+            0,
+            0.0f,
+            ULONG_MAX,
+            1.0f
+    };
+    graph.load_threads_ = std::max(1u, std::thread::hardware_concurrency());
+
+    if (argc < 4) {
+        std::cerr << "Converts overlap files into a filtered graph cache used by Telomeri.\n"
+                  << "Usage: telomeri-convert [option...] <read-read_overlap_file>.paf "
+                  << "<contig-read_overlap_file>.paf <output_file>.tgraph\n"
+                  << "       telomeri-convert --append <snapshot>.tgraph [--rr <file>.paf]... [--cr <file>.paf]... "
+                  << "<output_file>.tgraph\n"
+                  << "\n"
+                  << "Overlap files can be shard patterns, same as in Telomeri.\n"
+                  << "Filter and loading options are the same as Telomeri's and must match the ones\n"
+                  << "Telomeri is run with, otherwise the cache is considered stale.\n"
+                  << "\n"
+                  << "With --append, new read-read and contig-read overlap files are added to an existing\n"
+                  << "graph cache, filtered with the parameters it was built with. Run Telomeri with the\n"
+                  << "same files as --append-rr and --append-cr options to use the result.\n"
+                  << std::endl;
+        return 1;
+    }
+
+    if (std::string(argv[1]) == "--append") {
+        return append(graph, argc, argv);
+    }
+
+    char *rr_file = argv[argc - 3];
+    char *cr_file = argv[argc - 2];
+    char *output_file = argv[argc - 1];
+
+    std::vector<std::string> rr_files, cr_files;
+    if (!OverlapGraph::expandShards(rr_file, rr_files) || !OverlapGraph::expandShards(cr_file, cr_files)) {
+        std::cerr << "No overlap files found: " << rr_file << ", " << cr_file << std::endl;
+        return 1;
+    }
+    std::vector<const char *> input_files;
+    for (const std::vector<std::string> *files : {&rr_files, &cr_files}) {
+        for (const std::string &file : *files) {
+            input_files.push_back(file.c_str());
+        }
+    }
+
+    ulong fingerprint;
+    if (!GraphCache::fingerprint(input_files, fingerprint)) {
+        std::cerr << "Cannot access overlap files: " << rr_file << ", " << cr_file << std::endl;
+        return 1;
+    }
+
+    Stopwatch timer;
+    timer.start();
+
+    std::cout << "Loading overlaps..." << std::endl;
+    if (!graph.load(rr_files, false) || !graph.load(cr_files, true)) {
+        return 1;
+    }
+    std::cout << "Done (" << timer.lap() << "s)" << std::endl << graph.stats() << std::endl;
+
+    std::cout << "Writing graph cache: " << output_file << std::endl;
+    if (!GraphCache::write(graph, output_file, fingerprint)) {
+        std::cerr << "Cannot write file: " << output_file << std::endl;
+        return 1;
+    }
+    std::cout << "Done (" << timer.lap() << "s)" << std::endl;
+    return 0;
+}
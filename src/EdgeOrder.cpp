@@ -0,0 +1,36 @@
+#include <EdgeOrder.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+EdgeOrder::EdgeOrder(const OverlapGraph &g, Utils::Metrics metric)
+        : offsets_(g.offsets_), ranked_(g.adjacency_.size()) {
+    std::vector<uint> order, first, head;
+    for (const OverlapGraph::Node &n : g.nodes_) {
+        OverlapGraph::EdgeRange edges = g.edges(n);
+        const ulong begin = offsets_[n.index];
+
+        order.resize(edges.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint a, uint b) {
+            return Utils::getMetric(edges[a], metric) > Utils::getMetric(edges[b], metric);
+        });
+
+        // First edge to every neighbour: sort positions by neighbour, then
+        // load order, and spread the head of each run over the run.
+        first.resize(edges.size());
+        std::iota(first.begin(), first.end(), 0);
+        std::sort(first.begin(), first.end(), [&](uint a, uint b) {
+            return edges[a].q_index != edges[b].q_index ? edges[a].q_index < edges[b].q_index : a < b;
+        });
+        head.resize(edges.size());
+        for (size_t i = 0; i < first.size(); i++) {
+            bool run_start = i == 0 || edges[first[i]].q_index != edges[first[i - 1]].q_index;
+            head[first[i]] = run_start ? first[i] : head[first[i - 1]];
+        }
+
+        for (size_t i = 0; i < order.size(); i++) {
+            ranked_[begin + i] = &edges[head[order[i]]];
+        }
+    }
+}
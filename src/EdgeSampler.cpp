@@ -0,0 +1,117 @@
+#include <EdgeSampler.hpp>
+
+#include <algorithm>
+#include <random>
+
+EdgeSampler::EdgeSampler(const OverlapGraph &g, Utils::Metrics metric)
+        : g_(g), weight_(g.adjacency_.size()), prob_(g.adjacency_.size(), 1.0f),
+          alias_(g.adjacency_.size(), 0), weighted_(g.nodes_.size(), false) {
+    for (size_t i = 0; i < g.adjacency_.size(); i++) {
+        weight_[i] = Utils::getMetric(g.adjacency_[i], metric);
+    }
+
+    // Vose's alias method, one table per node.
+    std::vector<double> scaled;
+    std::vector<uint> small, large;
+    for (const OverlapGraph::Node &n : g.nodes_) {
+        const ulong first = g.offsets_[n.index];
+        const uint degree = static_cast<uint>(g.offsets_[n.index + 1] - first);
+
+        double total = 0;
+        for (uint i = 0; i < degree; i++) {
+            total += weight_[first + i];
+        }
+        if (!(total > 0)) {
+            continue;
+        }
+        weighted_[n.index] = true;
+
+        scaled.resize(degree);
+        small.clear();
+        large.clear();
+        for (uint i = 0; i < degree; i++) {
+            scaled[i] = weight_[first + i] * degree / total;
+            (scaled[i] < 1 ? small : large).push_back(i);
+        }
+        while (!small.empty() && !large.empty()) {
+            uint s = small.back(), l = large.back();
+            small.pop_back();
+            prob_[first + s] = static_cast<float>(scaled[s]);
+            alias_[first + s] = l;
+            scaled[l] -= 1 - scaled[s];
+            if (scaled[l] < 1) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Leftovers are 1 up to rounding errors.
+        for (uint i : small) {
+            prob_[first + i] = 1.0f;
+        }
+        for (uint i : large) {
+            prob_[first + i] = 1.0f;
+        }
+    }
+}
+
+const OverlapGraph::Edge *EdgeSampler::sample(const OverlapGraph::Node &n, const VisitedSet &visited,
+                                              RandomStream &gen, ulong &scans) const {
+    const ulong first = g_.offsets_[n.index];
+    const ulong degree = g_.offsets_[n.index + 1] - first;
+    if (degree == 0) {
+        return nullptr;
+    }
+
+    if (weighted_[n.index]) {
+        std::uniform_real_distribution<> dis(0., 1.);
+        for (int r = 0; r < MAX_REJECTIONS; r++) {
+            // Integer part selects the edge, fraction decides between it and its alias.
+            double u = dis(gen) * degree;
+            ulong i = std::min(static_cast<ulong>(u), degree - 1);
+            ulong k = first + (u - i < prob_[first + i] ? i : alias_[first + i]);
+
+            const OverlapGraph::Edge &e = g_.adjacency_[k];
+            if (!visited[e.q_index]) {
+                return &e;
+            }
+        }
+    }
+    ++scans;
+    return scan(n, visited, gen);
+}
+
+const OverlapGraph::Edge *EdgeSampler::scan(const OverlapGraph::Node &n, const VisitedSet &visited,
+                                            RandomStream &gen) const {
+    const ulong first = g_.offsets_[n.index], last = g_.offsets_[n.index + 1];
+
+    double sum = 0;
+    bool any = false;
+    for (ulong k = first; k < last; k++) {
+        if (!visited[g_.adjacency_[k].q_index]) {
+            sum += weight_[k];
+            any = true;
+        }
+    }
+    if (!any) {
+        return nullptr;
+    }
+
+    // Select a random number from [0, sum] and find the edge it falls on.
+    std::uniform_real_distribution<> dis(0., 1.);
+    double random = dis(gen) * sum;
+    const OverlapGraph::Edge *last_unvisited = nullptr;
+    sum = 0;
+    for (ulong k = first; k < last; k++) {
+        const OverlapGraph::Edge &e = g_.adjacency_[k];
+        if (visited[e.q_index]) {
+            continue;
+        }
+        sum += weight_[k];
+        last_unvisited = &e;
+        if (sum >= random) {
+            return &e;
+        }
+    }
+    // Rounding kept the running sum just below the random number.
+    return last_unvisited;
+}
@@ -0,0 +1,264 @@
+#include <GraphCache.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+
+#include <MappedFile.hpp>
+
+namespace {
+    const char MAGIC[8] = {'T', 'L', 'M', 'R', 'G', 'R', 'P', 'H'};
+    const uint32_t VERSION = 7;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t mode;
+        uint64_t fingerprint;
+        uint64_t min_overlap_length;
+        uint64_t max_overhang_length;
+        float min_overlap_percentage;
+        float max_overhang_percentage;
+        uint32_t skip_secondary;
+        uint32_t reserved; /**< Keeps the header free of padding bytes. */
+    };
+
+    struct CachedNode {
+        uint32_t length;
+        uint32_t anchor;
+    };
+
+    struct CachedEdge {
+        uint32_t q_index; /**< Target is the node the edge is stored at. */
+        uint32_t q_start, q_end, t_start, t_end;
+        float overlap_score, extension_score;
+        uint16_t identity; /**< Same encoding as in OverlapGraph::Edge. */
+        uint16_t reserved;
+    };
+
+    /** Arrays are stored as 64-bit element count followed by the elements,
+     * padded to 8 bytes so every array starts aligned. */
+    template<typename T>
+    void writeArray(std::ostream &s, const T *data, uint64_t n) {
+        static const char zeros[8] = {};
+        s.write(reinterpret_cast<const char *>(&n), sizeof(n));
+        s.write(reinterpret_cast<const char *>(data), n * sizeof(T));
+        s.write(zeros, (8 - n * sizeof(T) % 8) % 8);
+    }
+
+    template<typename T>
+    bool readArray(const char *&cur, const char *end, std::vector<T> &v) {
+        uint64_t n;
+        if (end - cur < static_cast<long>(sizeof(n))) {
+            return false;
+        }
+        std::memcpy(&n, cur, sizeof(n));
+        cur += sizeof(n);
+
+        uint64_t bytes = n * sizeof(T);
+        uint64_t padded = bytes + (8 - bytes % 8) % 8;
+        if (n > static_cast<uint64_t>(end - cur) / sizeof(T) || padded > static_cast<uint64_t>(end - cur)) {
+            return false;
+        }
+        v.resize(n);
+        std::memcpy(v.data(), cur, bytes);
+        cur += padded;
+        return true;
+    }
+
+    Header makeHeader(const OverlapGraph::FilterParameters &p, ulong fingerprint) {
+        Header h{};
+        std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = VERSION;
+        h.mode = p.mode;
+        h.fingerprint = fingerprint;
+        h.min_overlap_length = p.min_overlap_length;
+        h.max_overhang_length = p.max_overhang_length;
+        h.min_overlap_percentage = p.min_overlap_percentage;
+        h.max_overhang_percentage = p.max_overhang_percentage;
+        h.skip_secondary = p.skip_secondary;
+        return h;
+    }
+}
+
+bool GraphCache::fingerprint(const std::vector<const char *> &filepaths, ulong &fingerprint) {
+    fingerprint = 14695981039346656037ull;
+    return extendFingerprint(filepaths, fingerprint);
+}
+
+bool GraphCache::extendFingerprint(const std::vector<const char *> &filepaths, ulong &fingerprint) {
+    // FNV-1a over size and modification time of every file.
+    uint64_t h = fingerprint;
+    auto mix = [&h](uint64_t v) {
+        for (int i = 0; i < 8; i++, v >>= 8) {
+            h ^= v & 0xff;
+            h *= 1099511628211ull;
+        }
+    };
+
+    for (const char *filepath : filepaths) {
+        struct stat st{};
+        if (stat(filepath, &st) != 0 || !S_ISREG(st.st_mode)) {
+            return false;
+        }
+        mix(static_cast<uint64_t>(st.st_size));
+        mix(static_cast<uint64_t>(st.st_mtim.tv_sec));
+        mix(static_cast<uint64_t>(st.st_mtim.tv_nsec));
+    }
+
+    fingerprint = h;
+    return true;
+}
+
+bool GraphCache::write(const OverlapGraph &g, const char *filepath, ulong fingerprint) {
+    std::vector<CachedNode> nodes;
+    nodes.reserve(g.nodes_.size());
+    for (const OverlapGraph::Node &n : g.nodes_) {
+        nodes.push_back({n.length, n.anchor});
+    }
+
+    // Adjacency is stored as is, so reading it needs no sorting.
+    std::vector<CachedEdge> adjacency;
+    adjacency.reserve(g.adjacency_.size());
+    for (const OverlapGraph::Edge &e : g.adjacency_) {
+        adjacency.push_back({e.q_index, e.q_start, e.q_end, e.t_start, e.t_end,
+                             e.overlap_score, e.extension_score, e.identity_, 0});
+    }
+    std::vector<uint64_t> offsets(g.offsets_.begin(), g.offsets_.end());
+
+    // Write to a temporary file first so an interrupted write never leaves
+    // a truncated cache behind.
+    std::string tmp_path = std::string(filepath) + ".tmp";
+    std::ofstream s(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!s) {
+        return false;
+    }
+
+    Header h = makeHeader(g.filter_params_, fingerprint);
+    s.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    writeArray(s, nodes.data(), nodes.size());
+    writeArray(s, offsets.data(), offsets.size());
+    writeArray(s, adjacency.data(), adjacency.size());
+    writeArray(s, g.names_.arena_.data(), g.names_.arena_.size());
+    writeArray(s, g.names_.offsets_.data(), g.names_.offsets_.size());
+    writeArray(s, g.names_.slots_.data(), g.names_.slots_.size());
+    s.close();
+
+    if (!s || std::rename(tmp_path.c_str(), filepath) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool GraphCache::read(OverlapGraph &g, const char *filepath, ulong fingerprint) {
+    MappedFile file(filepath);
+    if (!file.valid() || file.size() < sizeof(Header)) {
+        return false;
+    }
+
+    Header h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    Header expected = makeHeader(g.filter_params_, fingerprint);
+    if (std::memcmp(&h, &expected, sizeof(h)) != 0) {
+        return false; // Different version, inputs or filter parameters.
+    }
+    return readGraph(g, file);
+}
+
+bool GraphCache::readSnapshot(OverlapGraph &g, const char *filepath, ulong &fingerprint) {
+    MappedFile file(filepath);
+    if (!file.valid() || file.size() < sizeof(Header)) {
+        return false;
+    }
+
+    Header h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION || h.mode > OverlapGraph::SUM
+        || !readGraph(g, file)) {
+        return false;
+    }
+
+    g.filter_params_.mode = static_cast<OverlapGraph::LengthCalculationMode>(h.mode);
+    g.filter_params_.min_overlap_length = h.min_overlap_length;
+    g.filter_params_.min_overlap_percentage = h.min_overlap_percentage;
+    g.filter_params_.max_overhang_length = h.max_overhang_length;
+    g.filter_params_.max_overhang_percentage = h.max_overhang_percentage;
+    g.filter_params_.skip_secondary = h.skip_secondary != 0;
+    fingerprint = h.fingerprint;
+    return true;
+}
+
+bool GraphCache::validName(const NameInterner &names, uint64_t offset) {
+    uint32_t len;
+    size_t size = names.arena_.size();
+    if (offset > size || size - offset < sizeof(len)) {
+        return false;
+    }
+    std::memcpy(&len, names.arena_.data() + offset, sizeof(len));
+    return len <= size - offset - sizeof(len);
+}
+
+bool GraphCache::readGraph(OverlapGraph &g, const MappedFile &file) {
+    const char *cur = file.data() + sizeof(Header);
+    const char *end = file.data() + file.size();
+    std::vector<CachedNode> nodes;
+    std::vector<uint64_t> offsets;
+    std::vector<CachedEdge> adjacency;
+    NameInterner names;
+    if (!readArray(cur, end, nodes) || !readArray(cur, end, offsets) || !readArray(cur, end, adjacency)
+        || !readArray(cur, end, names.arena_) || !readArray(cur, end, names.offsets_)
+        || !readArray(cur, end, names.slots_)) {
+        return false;
+    }
+
+    // Validate indices so a corrupted file cannot cause out of bounds access.
+    if (offsets.size() != nodes.size() + 1 || offsets.front() != 0 || offsets.back() != adjacency.size()
+        || names.offsets_.size() != nodes.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (offsets[i] > offsets[i + 1] || !validName(names, names.offsets_[i])) {
+            return false;
+        }
+    }
+
+    // Probing needs a power of two table with an empty slot, at the load
+    // factor intern() keeps, and every id must be a node.
+    size_t occupied = 0;
+    for (const NameInterner::Slot &slot : names.slots_) {
+        if (slot.id != NameInterner::NOT_FOUND && slot.id >= nodes.size()) {
+            return false;
+        }
+        occupied += slot.id != NameInterner::NOT_FOUND;
+    }
+    if ((names.slots_.size() & (names.slots_.size() - 1)) != 0 || occupied != nodes.size()
+        || occupied * 2 > names.slots_.size()) {
+        return false;
+    }
+    for (const CachedEdge &e : adjacency) {
+        if (e.q_index >= nodes.size()) {
+            return false;
+        }
+    }
+
+    g.nodes_.clear();
+    g.nodes_.reserve(nodes.size());
+    for (uint i = 0; i < nodes.size(); i++) {
+        g.nodes_.emplace_back(nodes[i].anchor != 0, i, nodes[i].length);
+    }
+    g.adjacency_.clear();
+    g.adjacency_.reserve(adjacency.size());
+    for (const CachedEdge &e : adjacency) {
+        g.adjacency_.emplace_back(e.q_index, e.q_start, e.q_end, e.t_start, e.t_end,
+                                  e.overlap_score, 0.0f, e.extension_score, false);
+        g.adjacency_.back().identity_ = e.identity;
+    }
+    g.offsets_.assign(offsets.begin(), offsets.end());
+    g.names_ = std::move(names);
+    g.buildAnchorIndex();
+    return true;
+}
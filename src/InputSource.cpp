@@ -0,0 +1,312 @@
+#include <InputSource.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+    /** Size of the compressed input buffer of a gzip stream. */
+    const size_t GZIP_INPUT_SIZE = 1 << 20;
+
+    /** Number of BGZF blocks decompressed in a batch, per thread. */
+    const size_t BGZF_BLOCKS_PER_THREAD = 16;
+
+    /** Largest decompressed size of a BGZF block allowed by the format. */
+    const size_t BGZF_MAX_BLOCK_SIZE = 1 << 16;
+
+    /** Reads until n bytes are read or the input ends. Returns number of
+     * bytes read, or -1 if an error occurred. */
+    long readFully(InputSource &in, char *buf, size_t n) {
+        size_t total = 0;
+        while (total < n) {
+            long r = in.read(buf + total, n - total);
+            if (r < 0) {
+                return -1;
+            }
+            if (r == 0) {
+                break;
+            }
+            total += r;
+        }
+        return static_cast<long>(total);
+    }
+
+    uint16_t readU16(const char *p) {
+        return static_cast<uint16_t>(static_cast<unsigned char>(p[0]) | static_cast<unsigned char>(p[1]) << 8);
+    }
+
+    uint32_t readU32(const char *p) {
+        return readU16(p) | static_cast<uint32_t>(readU16(p + 2)) << 16;
+    }
+
+    bool isGzip(const char *header, size_t n) {
+        return n >= 2 && header[0] == '\x1f' && header[1] == '\x8b';
+    }
+
+    /** Finds the 'BC' subfield in the extra field of a gzip header and
+     * returns the total block size, or 0 if there is none. */
+    size_t bgzfBlockSize(const char *extra, size_t xlen) {
+        for (size_t i = 0; i + 4 <= xlen;) {
+            uint16_t slen = readU16(extra + i + 2);
+            if (extra[i] == 'B' && extra[i + 1] == 'C' && slen == 2 && i + 6 <= xlen) {
+                return readU16(extra + i + 4) + 1ul;
+            }
+            i += 4 + slen;
+        }
+        return 0;
+    }
+
+    /** Size of the fixed part of a gzip member header, before the extra field. */
+    const size_t GZIP_HEADER_SIZE = 12;
+
+    /** Gzip header flag signaling the extra field is present. */
+    const char GZIP_FEXTRA = 4;
+
+    bool isBgzf(const char *header, size_t n) {
+        if (n < GZIP_HEADER_SIZE || !isGzip(header, n) || header[2] != 8 || !(header[3] & GZIP_FEXTRA)) {
+            return false;
+        }
+        size_t xlen = readU16(header + 10);
+        return n >= GZIP_HEADER_SIZE + xlen && bgzfBlockSize(header + GZIP_HEADER_SIZE, xlen) > 0;
+    }
+}
+
+std::unique_ptr<InputSource> InputSource::open(const char *filepath, unsigned threads) {
+    std::unique_ptr<FileSource> file;
+    if (std::strcmp(filepath, "-") == 0) {
+        file = std::make_unique<FileSource>(STDIN_FILENO, false);
+    } else {
+        int fd = ::open(filepath, O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        file = std::make_unique<FileSource>(fd, true);
+    }
+
+    // Detect the format from the first gzip header. Bgzip always writes the
+    // 'BC' subfield first, so 18 bytes are enough.
+    char header[18];
+    long n = readFully(*file, header, sizeof(header));
+    if (n < 0) {
+        return nullptr;
+    }
+    file->unread(header, n);
+
+    if (isBgzf(header, n)) {
+        return std::make_unique<BgzfSource>(std::move(file), std::max(1u, threads));
+    }
+    if (isGzip(header, n)) {
+        return std::make_unique<GzipSource>(std::move(file));
+    }
+    return file;
+}
+
+bool InputSource::isCompressed(const char *filepath) {
+    int fd = ::open(filepath, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    FileSource file(fd, true);
+    char magic[2];
+    return isGzip(magic, readFully(file, magic, sizeof(magic)));
+}
+
+FileSource::~FileSource() {
+    if (owned_) {
+        close(fd_);
+    }
+}
+
+long FileSource::read(char *buf, size_t n) {
+    if (!pending_.empty()) {
+        size_t r = std::min(n, pending_.size());
+        std::memcpy(buf, pending_.data(), r);
+        pending_.erase(pending_.begin(), pending_.begin() + r);
+        return static_cast<long>(r);
+    }
+
+    while (true) {
+        ssize_t r = ::read(fd_, buf, n);
+        if (r >= 0 || errno != EINTR) {
+            return r;
+        }
+    }
+}
+
+void FileSource::unread(const char *data, size_t n) {
+    pending_.insert(pending_.begin(), data, data + n);
+}
+
+struct GzipSource::Stream {
+    z_stream z{};
+    bool in_member = false; /**< Inside a member, end of input would truncate it. */
+    bool initialized = false; /**< Inflate state was allocated. */
+};
+
+GzipSource::GzipSource(std::unique_ptr<InputSource> in)
+        : in_(std::move(in)), stream_(std::make_unique<Stream>()), input_(GZIP_INPUT_SIZE) {
+    // Maximum window, gzip wrapper.
+    stream_->initialized = inflateInit2(&stream_->z, 15 + 16) == Z_OK;
+}
+
+GzipSource::~GzipSource() {
+    if (stream_->initialized) {
+        inflateEnd(&stream_->z);
+    }
+}
+
+long GzipSource::read(char *buf, size_t n) {
+    if (!stream_->initialized) {
+        return -1;
+    }
+    z_stream &z = stream_->z;
+    uInt capacity = static_cast<uInt>(std::min<size_t>(n, UINT_MAX));
+    z.next_out = reinterpret_cast<Bytef *>(buf);
+    z.avail_out = capacity;
+
+    while (z.avail_out == capacity) { // Block until at least one byte is produced.
+        if (z.avail_in == 0 && !eof_) {
+            long r = in_->read(input_.data(), input_.size());
+            if (r < 0) {
+                return -1;
+            }
+            eof_ = r == 0;
+            z.next_in = reinterpret_cast<Bytef *>(input_.data());
+            z.avail_in = static_cast<uInt>(r);
+        }
+        if (z.avail_in == 0 && eof_) {
+            return stream_->in_member ? -1 : 0; // Truncated member is an error.
+        }
+
+        stream_->in_member = true;
+        int ret = inflate(&z, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) { // Another member may follow.
+            stream_->in_member = false;
+            inflateReset(&z);
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            return -1;
+        }
+    }
+    return static_cast<long>(capacity - z.avail_out);
+}
+
+BgzfSource::BgzfSource(std::unique_ptr<InputSource> in, unsigned threads)
+        : in_(std::move(in)), threads_(threads) {}
+
+bool BgzfSource::fill() {
+    struct Block {
+        size_t input_offset, input_size; /**< Raw deflate data in compressed. */
+        size_t output_offset, output_size;
+        uint32_t crc;
+    };
+
+    // Read whole blocks, their trailers give the decompressed sizes.
+    std::vector<char> compressed, extra;
+    std::vector<Block> blocks;
+    size_t output_size = 0;
+    while (blocks.size() < BGZF_BLOCKS_PER_THREAD * threads_) {
+        char header[GZIP_HEADER_SIZE];
+        long r = readFully(*in_, header, sizeof(header));
+        if (r == 0) {
+            eof_ = true;
+            break;
+        }
+        if (r != static_cast<long>(sizeof(header)) || !isGzip(header, r) || !(header[3] & GZIP_FEXTRA)) {
+            return false;
+        }
+
+        size_t xlen = readU16(header + 10);
+        extra.resize(xlen);
+        if (readFully(*in_, extra.data(), xlen) != static_cast<long>(xlen)) {
+            return false;
+        }
+        size_t block_size = bgzfBlockSize(extra.data(), xlen);
+        if (block_size < GZIP_HEADER_SIZE + xlen + 8) {
+            return false;
+        }
+
+        // Deflate data followed by CRC32 and decompressed size.
+        size_t rest = block_size - GZIP_HEADER_SIZE - xlen;
+        size_t offset = compressed.size();
+        compressed.resize(offset + rest);
+        if (readFully(*in_, compressed.data() + offset, rest) != static_cast<long>(rest)) {
+            return false;
+        }
+        const char *trailer = compressed.data() + offset + rest - 8;
+        Block b{offset, rest - 8, output_size, readU32(trailer + 4), readU32(trailer)};
+        if (b.output_size > BGZF_MAX_BLOCK_SIZE) { // Checked before the size is allocated.
+            return false;
+        }
+        output_size += b.output_size;
+        blocks.push_back(b);
+    }
+
+    output_.resize(output_size);
+    position_ = 0;
+
+    // Inflate contiguous ranges of blocks in parallel, every block into its place.
+    unsigned workers_num = static_cast<unsigned>(std::min<size_t>(threads_, blocks.size()));
+    std::vector<char> ok(std::max(1u, workers_num), 1);
+    auto inflateRange = [&](unsigned w) {
+        z_stream z{};
+        if (inflateInit2(&z, -15) != Z_OK) { // Raw deflate, headers were parsed above.
+            ok[w] = 0;
+            return;
+        }
+        for (size_t i = blocks.size() * w / workers_num; i < blocks.size() * (w + 1) / workers_num; i++) {
+            const Block &b = blocks[i];
+            // Empty blocks, like the end of file marker, get a dummy byte,
+            // inflate() rejects a null output even when it writes nothing.
+            Bytef empty;
+            Bytef *out = b.output_size > 0 ? reinterpret_cast<Bytef *>(output_.data() + b.output_offset) : &empty;
+            inflateReset(&z);
+            z.next_in = reinterpret_cast<Bytef *>(compressed.data() + b.input_offset);
+            z.avail_in = static_cast<uInt>(b.input_size);
+            z.next_out = out;
+            z.avail_out = static_cast<uInt>(b.output_size);
+            if (inflate(&z, Z_FINISH) != Z_STREAM_END || z.avail_out != 0
+                || crc32(crc32(0, nullptr, 0), out, static_cast<uInt>(b.output_size)) != b.crc) {
+                ok[w] = 0;
+                break;
+            }
+        }
+        inflateEnd(&z);
+    };
+
+    if (workers_num <= 1) {
+        if (workers_num == 1) {
+            inflateRange(0);
+        }
+    } else {
+        std::vector<std::thread> workers;
+        for (unsigned w = 0; w < workers_num; w++) {
+            workers.emplace_back(inflateRange, w);
+        }
+        for (std::thread &t : workers) {
+            t.join();
+        }
+    }
+    return std::all_of(ok.begin(), ok.end(), [](char c) { return c != 0; });
+}
+
+long BgzfSource::read(char *buf, size_t n) {
+    while (position_ == output_.size()) {
+        if (eof_) {
+            return 0;
+        }
+        if (!fill()) {
+            return -1;
+        }
+    }
+
+    size_t r = std::min(n, output_.size() - position_);
+    std::memcpy(buf, output_.data() + position_, r);
+    position_ += r;
+    return static_cast<long>(r);
+}
@@ -0,0 +1,74 @@
+#include <LoadStats.hpp>
+
+ulong LoadStats::earlyRejects() const {
+    return secondary_rejects + overlap_length_rejects + overlap_percentage_rejects
+           + overhang_length_rejects + overhang_percentage_rejects;
+}
+
+void LoadStats::merge(const LoadStats &other) {
+    bytes += other.bytes;
+    lines += other.lines;
+    edges += other.edges;
+    nodes += other.nodes;
+    time += other.time;
+    parse_time += other.parse_time;
+    filter_time += other.filter_time;
+    build_time += other.build_time;
+    read_time += other.read_time;
+    secondary_rejects += other.secondary_rejects;
+    self_rejects += other.self_rejects;
+    overlap_length_rejects += other.overlap_length_rejects;
+    overlap_percentage_rejects += other.overlap_percentage_rejects;
+    overhang_length_rejects += other.overhang_length_rejects;
+    overhang_percentage_rejects += other.overhang_percentage_rejects;
+    name_lookups += other.name_lookups;
+    name_hits += other.name_hits;
+}
+
+void LoadStats::toStream(std::ostream &s) const {
+    s << "-   bytes: " << bytes << '\n'
+      << "-   lines: " << lines << " (" << linesPerSecond() << " lines/s, " << bytesPerSecond() / 1e9 << " GB/s)\n"
+      << "-   edges: " << edges << '\n'
+      << "-    time: " << time << "s (parse " << parse_time << "s, filter " << filter_time
+      << "s, build " << build_time << "s, read " << read_time << "s)\n"
+      << "- rejects: secondary " << secondary_rejects << ", self " << self_rejects
+      << ", min_OL " << overlap_length_rejects << ", min_OL% " << overlap_percentage_rejects
+      << ", max_OH " << overhang_length_rejects << ", max_OH% " << overhang_percentage_rejects << '\n'
+      << "- name_hr: " << nameHitRate() << " (" << name_hits << '/' << name_lookups << ")\n";
+}
+
+void LoadStats::toJson(std::ostream &s) const {
+    s << '{';
+    if (!file.empty()) {
+        s << "\"file\": \"";
+        for (char c : file) {
+            if (c == '"' || c == '\\') {
+                s << '\\';
+            }
+            s << c;
+        }
+        s << "\", ";
+    }
+    s << "\"bytes\": " << bytes
+      << ", \"lines\": " << lines
+      << ", \"edges\": " << edges
+      << ", \"nodes\": " << nodes
+      << ", \"time\": " << time
+      << ", \"parse_time\": " << parse_time
+      << ", \"filter_time\": " << filter_time
+      << ", \"build_time\": " << build_time
+      << ", \"read_time\": " << read_time
+      << ", \"lines_per_second\": " << linesPerSecond()
+      << ", \"bytes_per_second\": " << bytesPerSecond()
+      << ", \"rejects\": {"
+      << "\"secondary\": " << secondary_rejects
+      << ", \"self\": " << self_rejects
+      << ", \"min_overlap_length\": " << overlap_length_rejects
+      << ", \"min_overlap_percentage\": " << overlap_percentage_rejects
+      << ", \"max_overhang_length\": " << overhang_length_rejects
+      << ", \"max_overhang_percentage\": " << overhang_percentage_rejects
+      << "}, \"name_lookups\": " << name_lookups
+      << ", \"name_hits\": " << name_hits
+      << ", \"name_hit_rate\": " << nameHitRate()
+      << '}';
+}
@@ -1,51 +1,17 @@
+#include <fstream>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <PathManager.hpp>
 #include <Stopwatch.hpp>
 #include <Scaffolder.hpp>
+#include <GraphCache.hpp>
 
 enum ParseState {
-    NONE, OLL, OLP, OHL, OHP, RB_ATT, BT_ATT, LEN_THR, W_SIZE, R_THR
+    NONE, OLL, OLP, OHL, OHP, THREADS, CACHE, STATS, APPEND_RR, APPEND_CR, RB_ATT, BT_ATT, LEN_THR, W_SIZE, R_THR, SEED
 };
 
-ulong try_parse_pos_num(const char *s) {
-    try {
-        long v = std::stol(s);
-
-        if (v < 0) {
-            std::cerr << "Value must be positive: " << s << std::endl;
-            exit(1);
-        }
-
-        return static_cast<ulong>(v);
-    } catch (std::invalid_argument &e) {
-        std::cerr << "Invalid int value: " << s << std::endl;
-    } catch (std::out_of_range &e) {
-        std::cerr << "Provided value is outside of int range: " << s << std::endl;
-    }
-
-    exit(1);
-}
-
-float try_parse_perc(const char *s) {
-    try {
-        float v = std::stof(s);
-
-        if (v < 0.0f || v > 1.0f) {
-            std::cerr << "Value must be in range [0.0, 1.0]: " << s << std::endl;
-            exit(1);
-        }
-
-        return v;
-    } catch (std::invalid_argument &e) {
-        std::cerr << "Invalid float value: " << s << std::endl;
-    } catch (std::out_of_range &e) {
-        std::cerr << "Provided value is outside of float range: " << s << std::endl;
-    }
-
-    exit(1);
-}
-
 int main(int argc, char **argv) {
     char *rr_file;
     char *cr_file;
@@ -53,6 +19,12 @@ int main(int argc, char **argv) {
     char *contigs_file;
     char *output_file;
     const char *mode_string = "AVG";
+    OverlapGraph::LoaderMode loader_mode = OverlapGraph::MMAP;
+    uint threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string cache_file;
+    bool use_cache = true;
+    std::string stats_file;
+    std::vector<const char *> append_rr_files, append_cr_files;
     OverlapGraph::FilterParameters filter_params = {
             OverlapGraph::AVG,
             0,
@@ -72,6 +44,9 @@ int main(int argc, char **argv) {
         std::cerr << "Please provide a path to read-read and contig-read files!\n"
                   << "Usage: hera [option...] <read-read_overlap_file>.paf <contig-read_overlap_file>.paf "
                   << "<reads_file>.fasta <contigs_file>.fasta <output_file>.fasta\n"
+                  << "Overlap files can be named pipes, or '-' to read one of them from standard input.\n"
+                  << "Sharded overlap files can be given as a quoted glob pattern ('rr_*.paf') or as '@list.txt',\n"
+                  << "a file listing the shards one per line. Shards are loaded in parallel.\n"
                   << "\n"
                   << "Available filter options:\n"
                   << "    --filter-avg         Use average length in filter comparisons (default value).\n"
@@ -82,6 +57,18 @@ int main(int argc, char **argv) {
                   << "    --min-olp <value>    Minimum required overlap percentage (default = 0).\n"
                   << "    --max-ohl <value>    Maximum allowed overhang length (default = INT_MAX).\n"
                   << "    --max-ohP <value>    Maximum allowed overhang percentage (default = 1.0).\n"
+                  << "    --skip-secondary     Discard secondary alignments (tp:A:S) while parsing.\n"
+                  << "\n"
+                  << "Available loading options:\n"
+                  << "    --load-istream       Read overlap files through iostreams instead of memory-mapping them.\n"
+                  << "    --threads <value>    Number of worker threads (default = number of cores).\n"
+                  << "    --cache <file>       Filtered graph cache, rebuilt when inputs or filter options change "
+                  << "(default = <first read-read_overlap_file>.tgraph).\n"
+                  << "    --no-cache           Always load the overlap files and don't write the graph cache.\n"
+                  << "    --stats <file>       Write graph and loader statistics to the file as JSON.\n"
+                  << "    --append-rr <file>   Additional read-read overlap file, can be repeated. Appended to the "
+                  << "graph cache of the main overlap files if there is one.\n"
+                  << "    --append-cr <file>   Additional contig-read overlap file, can be repeated.\n"
                   << "\n"
                   << "Available path construction options:\n"
                   << "    --rb-att  <value>    Number of path rebuild attempts if dead-end has been reached "
@@ -93,6 +80,8 @@ int main(int argc, char **argv) {
                   << "    --w-size <value>     Window size in path length (default = 1000).\n"
                   << "    --r-thr              Valley and peak ratio needed for splitting the paths into groups "
                   << "according to lowest path length frequency in the valley window (default = 0.9).\n"
+                  << "    --seed <value>       Seed of the Monte Carlo heuristic. Paths only depend on the seed, "
+                  << "not on the number of threads (default = 0).\n"
                   << "\n"
                   << "Percentages are in range [0.0, 1.0].\n"
                   << std::endl;
@@ -116,6 +105,22 @@ int main(int argc, char **argv) {
                     } else if (arg == "--filter-sum") {
                         filter_params.mode = OverlapGraph::SUM;
                         mode_string = "SUM";
+                    } else if (arg == "--skip-secondary") {
+                        filter_params.skip_secondary = true;
+                    } else if (arg == "--load-istream") {
+                        loader_mode = OverlapGraph::ISTREAM;
+                    } else if (arg == "--threads") {
+                        parse_state = THREADS;
+                    } else if (arg == "--cache") {
+                        parse_state = CACHE;
+                    } else if (arg == "--no-cache") {
+                        use_cache = false;
+                    } else if (arg == "--stats") {
+                        parse_state = STATS;
+                    } else if (arg == "--append-rr") {
+                        parse_state = APPEND_RR;
+                    } else if (arg == "--append-cr") {
+                        parse_state = APPEND_CR;
                     } else if (arg == "--min-oll") {
                         parse_state = OLL;
                     } else if (arg == "--min-olp") {
@@ -134,45 +139,71 @@ int main(int argc, char **argv) {
                         parse_state = W_SIZE;
                     } else if (arg == "--r-thr") {
                         parse_state = R_THR;
+                    } else if (arg == "--seed") {
+                        parse_state = SEED;
                     } else {
                         std::cerr << "Unknown argument: " << arg << std::endl;
                         return 1;
                     }
                     break;
                 case OLL:
-                    filter_params.min_overlap_length = try_parse_pos_num(argv[i]);
+                    filter_params.min_overlap_length = Utils::tryParsePosNum(argv[i]);
                     parse_state = NONE;
                     break;
                 case OLP:
-                    filter_params.min_overlap_percentage = try_parse_perc(argv[i]);
+                    filter_params.min_overlap_percentage = Utils::tryParsePerc(argv[i]);
                     parse_state = NONE;
                     break;
                 case OHL:
-                    filter_params.max_overhang_length = try_parse_pos_num(argv[i]);
+                    filter_params.max_overhang_length = Utils::tryParsePosNum(argv[i]);
                     parse_state = NONE;
                     break;
                 case OHP:
-                    filter_params.max_overhang_percentage = try_parse_perc(argv[i]);
+                    filter_params.max_overhang_percentage = Utils::tryParsePerc(argv[i]);
+                    parse_state = NONE;
+                    break;
+                case THREADS:
+                    threads = std::max(1ul, Utils::tryParsePosNum(argv[i]));
+                    parse_state = NONE;
+                    break;
+                case CACHE:
+                    cache_file = argv[i];
+                    parse_state = NONE;
+                    break;
+                case STATS:
+                    stats_file = argv[i];
+                    parse_state = NONE;
+                    break;
+                case APPEND_RR:
+                    append_rr_files.push_back(argv[i]);
+                    parse_state = NONE;
+                    break;
+                case APPEND_CR:
+                    append_cr_files.push_back(argv[i]);
                     parse_state = NONE;
                     break;
                 case RB_ATT:
-                    pm_params.rebuild_attempts = (int) try_parse_pos_num(argv[i]);
+                    pm_params.rebuild_attempts = (int) Utils::tryParsePosNum(argv[i]);
                     parse_state = NONE;
                     break;
                 case BT_ATT:
-                    pm_params.backtrack_attempts = (int) try_parse_pos_num(argv[i]);
+                    pm_params.backtrack_attempts = (int) Utils::tryParsePosNum(argv[i]);
                     parse_state = NONE;
                     break;
                 case LEN_THR:
-                    pm_params.len_threshold = (long) try_parse_pos_num(argv[i]);
+                    pm_params.len_threshold = (long) Utils::tryParsePosNum(argv[i]);
                     parse_state = NONE;
                     break;
                 case W_SIZE:
-                    pm_params.window_size = try_parse_pos_num(argv[i]);
+                    pm_params.window_size = Utils::tryParsePosNum(argv[i]);
                     parse_state = NONE;
                     break;
                 case R_THR:
-                    pm_params.ratio_threshold = try_parse_perc(argv[i]);
+                    pm_params.ratio_threshold = Utils::tryParsePerc(argv[i]);
+                    parse_state = NONE;
+                    break;
+                case SEED:
+                    pm_params.seed = Utils::tryParsePosNum(argv[i]);
                     parse_state = NONE;
                     break;
             }
@@ -191,18 +222,33 @@ int main(int argc, char **argv) {
         output_file = argv[5];
     }
 
+    if (std::string(rr_file) == "-" && std::string(cr_file) == "-") {
+        std::cerr << "Only one of the overlap files can be read from standard input!" << std::endl;
+        return 1;
+    }
+
+    // Overlap files can be given as shards, e.g. 'rr_*.paf' or '@rr_shards.txt'.
+    std::vector<std::string> rr_files, cr_files;
+    if (!OverlapGraph::expandShards(rr_file, rr_files) || !OverlapGraph::expandShards(cr_file, cr_files)) {
+        std::cerr << "No overlap files found: " << rr_file << ", " << cr_file << std::endl;
+        return 1;
+    }
+
     std::cout << "Filter:\n"
               << "    Mode: " << mode_string << "\n"
               << "    Min overlap length: " << filter_params.min_overlap_length << "\n"
               << "    Min overlap percentage: " << filter_params.min_overlap_percentage << "\n"
               << "    Max overhang length: " << filter_params.max_overhang_length << "\n"
-              << "    Max overhang percentage: " << filter_params.max_overhang_percentage << std::endl;
+              << "    Max overhang percentage: " << filter_params.max_overhang_percentage << "\n"
+              << "    Skip secondary: " << (filter_params.skip_secondary ? "yes" : "no") << "\n"
+              << "Threads: " << threads << std::endl;
     std::cout << "Path construction:\n"
               << "    Rebuild attempts: " << pm_params.rebuild_attempts << "\n"
               << "    Backtrack attempts: " << pm_params.backtrack_attempts << "\n"
               << "    Length threshold: " << pm_params.len_threshold << "\n"
               << "    Window size: " << pm_params.window_size << "\n"
               << "    Ratio threshold: " << pm_params.ratio_threshold << "\n"
+              << "    Seed: " << pm_params.seed << "\n"
               << std::endl;
 
     Stopwatch timer;
@@ -215,15 +261,66 @@ int main(int argc, char **argv) {
     graph.filter_params_.min_overlap_percentage = filter_params.min_overlap_percentage;
     graph.filter_params_.max_overhang_length = filter_params.max_overhang_length;
     graph.filter_params_.max_overhang_percentage = filter_params.max_overhang_percentage;
+    graph.filter_params_.skip_secondary = filter_params.skip_secondary;
+    graph.loader_mode_ = loader_mode;
+    graph.load_threads_ = threads;
 
     // FIXME Just for testing.
 //    graph.test_load_num_ = 100000;
 
-    std::cout << "\nLoading overlaps..." << std::endl;
-    if (!graph.load(rr_file, false) || !graph.load(cr_file, true)) {
-        return 1;
+    if (cache_file.empty()) {
+        cache_file = rr_files[0] + ".tgraph";
+    }
+    // Appended files are loaded after the main ones, read-read files first.
+    std::vector<const char *> append_files(append_rr_files);
+    append_files.insert(append_files.end(), append_cr_files.begin(), append_cr_files.end());
+    auto loadAppended = [&]() {
+        return graph.load(std::vector<std::string>(append_rr_files.begin(), append_rr_files.end()), false)
+               && graph.load(std::vector<std::string>(append_cr_files.begin(), append_cr_files.end()), true);
+    };
+
+    ulong base_fingerprint, fingerprint;
+    std::vector<const char *> input_files;
+    for (const std::vector<std::string> *files : {&rr_files, &cr_files}) {
+        for (const std::string &file : *files) {
+            input_files.push_back(file.c_str());
+        }
+    }
+    use_cache = use_cache && GraphCache::fingerprint(input_files, base_fingerprint);
+    fingerprint = base_fingerprint;
+    use_cache = use_cache && GraphCache::extendFingerprint(append_files, fingerprint);
+
+    if (use_cache && GraphCache::read(graph, cache_file.c_str(), fingerprint)) {
+        std::cout << "\nLoaded graph cache: " << cache_file << std::endl;
+    } else {
+        if (use_cache && !append_files.empty() && GraphCache::read(graph, cache_file.c_str(), base_fingerprint)) {
+            // Only the new overlaps need to be parsed and filtered.
+            std::cout << "\nLoaded graph cache: " << cache_file << "\nAppending overlaps..." << std::endl;
+            if (!loadAppended()) {
+                return 1;
+            }
+        } else {
+            std::cout << "\nLoading overlaps..." << std::endl;
+            if (!graph.load(rr_files, false) || !graph.load(cr_files, true) || !loadAppended()) {
+                return 1;
+            }
+        }
+        if (use_cache) {
+            if (GraphCache::write(graph, cache_file.c_str(), fingerprint)) {
+                std::cout << "Wrote graph cache: " << cache_file << std::endl;
+            } else {
+                std::cerr << "Cannot write graph cache: " << cache_file << std::endl;
+            }
+        }
     }
     std::cout << "Done (" << timer.lap() << "s)" << std::endl << graph.stats() << std::endl;
+    if (!stats_file.empty()) {
+        std::ofstream stats(stats_file);
+        stats << graph.statsJson() << std::endl;
+        if (!stats) {
+            std::cerr << "Cannot write file: " << stats_file << std::endl;
+        }
+    }
 
     // Construct paths with following heuristics.
     std::cout << "Calculating paths..." << std::endl;
@@ -233,6 +330,8 @@ int main(int argc, char **argv) {
     pm.params_.len_threshold = pm_params.len_threshold;
     pm.params_.window_size = pm_params.window_size;
     pm.params_.ratio_threshold = pm_params.ratio_threshold;
+    pm.params_.seed = pm_params.seed;
+    pm.params_.threads = threads;
 
     pm.buildMonteCarlo(graph, Utils::Metrics::EXTENSION_SCORE);
 //    pm.buildMonteCarlo(graph, Utils::Metrics::EXTENSION_SCORE_SQRT);
@@ -260,8 +359,8 @@ int main(int argc, char **argv) {
         const OverlapGraph::Node &anchor2 = *pbai.first.second; // End anchor.
         std::vector<const Path *> &paths = pbai.second;         // Paths connecting begin and end anchor.
 
-        std::cout << "====> Constructing groups for paths between anchor '" << anchor1.name
-                  << "' and anchor '" << anchor2.name << "'..." << std::endl;
+        std::cout << "====> Constructing groups for paths between anchor '" << graph.name(anchor1)
+                  << "' and anchor '" << graph.name(anchor2) << "'..." << std::endl;
         std::vector<PathGroup> pgs = PathManager::constructGroups(paths, pm.params_);
 #ifdef DEBUG
         for (size_t i = 0; i < pgs.size(); i++) {
@@ -269,7 +368,7 @@ int main(int argc, char **argv) {
         }
 #endif
         std::cout << "<==== Finished constructing groups for paths between anchor '"
-                  << anchor1.name << "' and anchor '" << anchor2.name << "'!\n" << std::endl;
+                  << graph.name(anchor1) << "' and anchor '" << graph.name(anchor2) << "'!\n" << std::endl;
 
         groups_for_anchors[{&anchor1, &anchor2}] = pgs; // Store all groups for the anchor in the map of path groups.
     }
@@ -282,8 +381,8 @@ int main(int argc, char **argv) {
     for (auto &anchors_groups_pair : groups_for_anchors) { // Iterate over map, ([a1, a2], path_groups) pairs.
         const OverlapGraph::Node &anchor1 = *anchors_groups_pair.first.first;  // Begin anchor.
         const OverlapGraph::Node &anchor2 = *anchors_groups_pair.first.second; // End anchor.
-        std::cout << "====> Finding consensus path in each group between anchor '" << anchor1.name
-                  << "' and anchor '" << anchor2.name << "'..." << std::endl;
+        std::cout << "====> Finding consensus path in each group between anchor '" << graph.name(anchor1)
+                  << "' and anchor '" << graph.name(anchor2) << "'..." << std::endl;
         std::vector<PathGroup> &pgs = anchors_groups_pair.second;
 
         std::vector<PathGroup *> pgswc;    // Path groups with consensus (not all have it). Filled in the following for loop.
@@ -337,8 +436,8 @@ int main(int argc, char **argv) {
             std::cout << "Final consensus (consensus among groups) length: " << consensus->length() << '\n';
         else
             std::cout << "Final consensus not found!\n";
-        std::cout << "====> Done finding consensus between anchor '" << anchor1.name
-                  << "' and anchor '" << anchor2.name << "'!" << std::endl;
+        std::cout << "====> Done finding consensus between anchor '" << graph.name(anchor1)
+                  << "' and anchor '" << graph.name(anchor2) << "'!" << std::endl;
     }
 
     if (consensus_num == 0) {
@@ -354,7 +453,7 @@ int main(int argc, char **argv) {
 
     // Load sequences for the final scaffold.
     std::cout << "\nLoading files for scaffolding..." << std::endl;
-    Scaffolder scaff(scaffold);
+    Scaffolder scaff(scaffold, graph);
     if (!scaff.load(reads_file) || !scaff.load(contigs_file)) {
         return 1;
     }
@@ -370,7 +469,7 @@ int main(int argc, char **argv) {
 //    scaffold.edges_.push_back(new OverlapGraph::Edge(1, 2, 1, 2, 0, 1, 0, 0, 0));
 //    scaffold.edges_.push_back(new OverlapGraph::Edge(2, 3, 3, 4, 3, 4, 0, 0, 0));
 //
-//    Scaffolder scaff(scaffold);
+//    Scaffolder scaff(scaffold, graph);
 //    scaff.names_.push_back("0");
 //    scaff.names_.push_back("1");
 //    scaff.names_.push_back("2");
@@ -0,0 +1,42 @@
+#include <MappedFile.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char *filepath) {
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            size_ = 0;
+            return;
+        }
+        // File is parsed front to back, let the kernel read ahead aggressively.
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(p);
+    }
+
+    // Mapping stays valid after the descriptor is closed.
+    close(fd);
+    valid_ = true;
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<char *>(data_), size_);
+    }
+}
@@ -0,0 +1,82 @@
+#include <NameInterner.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+uint NameInterner::find(std::string_view name) const {
+    if (slots_.empty()) {
+        return NOT_FOUND;
+    }
+    return slots_[probe(name, hash(name))].id;
+}
+
+uint NameInterner::intern(std::string_view name, bool &inserted) {
+    // Keep load factor at or below 1/2 so probe sequences stay short.
+    if ((offsets_.size() + 1) * 2 > slots_.size()) {
+        grow();
+    }
+
+    uint h = hash(name);
+    Slot &slot = slots_[probe(name, h)];
+    if (slot.id != NOT_FOUND) {
+        inserted = false;
+        return slot.id;
+    }
+
+    // Append length and characters to the arena.
+    uint len = static_cast<uint>(name.size());
+    size_t offset = arena_.size();
+    arena_.resize(offset + sizeof(len) + len);
+    std::memcpy(arena_.data() + offset, &len, sizeof(len));
+    std::memcpy(arena_.data() + offset + sizeof(len), name.data(), len);
+
+    slot.hash = h;
+    slot.id = static_cast<uint>(offsets_.size());
+    offsets_.push_back(offset);
+    inserted = true;
+    return slot.id;
+}
+
+std::string_view NameInterner::name(uint64_t offset) const {
+    uint len;
+    std::memcpy(&len, arena_.data() + offset, sizeof(len));
+    return {arena_.data() + offset + sizeof(len), len};
+}
+
+uint NameInterner::hash(std::string_view name) {
+    // 64-bit FNV-1a, folded to 32 bits.
+    unsigned long long h = 14695981039346656037ull;
+    for (char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return static_cast<uint>(h ^ (h >> 32));
+}
+
+size_t NameInterner::probe(std::string_view name, uint h) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        const Slot &slot = slots_[i];
+        if (slot.id == NOT_FOUND
+            || (slot.hash == h && this->name(offsets_[slot.id]) == name)) {
+            return i;
+        }
+    }
+}
+
+void NameInterner::grow() {
+    std::vector<Slot> old(std::max<size_t>(16, slots_.size() * 2), Slot{0, NOT_FOUND});
+    old.swap(slots_);
+
+    size_t mask = slots_.size() - 1;
+    for (const Slot &slot : old) {
+        if (slot.id == NOT_FOUND) {
+            continue;
+        }
+        size_t i = slot.hash & mask;
+        while (slots_[i].id != NOT_FOUND) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = slot;
+    }
+}
@@ -0,0 +1,271 @@
+#include <OverlapBatch.hpp>
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TELOMERI_X86
+
+#include <immintrin.h>
+#endif
+
+namespace {
+    /** Filter columns of a batch, see OverlapGraph::filter() for the predicates. */
+    struct Columns {
+        const int32_t *query_len, *query_start, *query_end;
+        const int32_t *target_len, *target_start, *target_end;
+    };
+
+    /** Filter parameters converted to the types the comparisons are made in. */
+    struct Thresholds {
+        OverlapGraph::LengthCalculationMode mode;
+        float min_overlap_length, min_overlap_percentage;
+        float max_overhang_length, max_overhang_percentage;
+    };
+
+    /** Per-check masks of failed records, indexed by FilterResult. */
+    typedef uint64_t *FailMasks[OverlapGraph::HIGH_OVERHANG_PERCENTAGE + 1];
+
+    typedef size_t (*KernelFunction)(const Columns &, const Thresholds &, size_t, FailMasks);
+
+#ifdef TELOMERI_X86
+    /* Lengths are combined exactly as in OverlapGraph::filter(): minimum and
+     * maximum are taken on floats, which equals converting the integer
+     * minimum or maximum, while average and sum add integers before the
+     * conversion. Every check is evaluated and reported in its own mask, with
+     * the scalar comparison semantics: the overlap checks fail on an ordered
+     * less-than and the overhang checks on a negated less-or-equal, so a NaN
+     * ratio fails the overhang check but never the overlap check. */
+
+    /** Evaluates records [0, n - n % 4) and returns the number evaluated. */
+    size_t filterSSE2(const Columns &c, const Thresholds &t, size_t n, FailMasks failed) {
+        const __m128 min_ol = _mm_set1_ps(t.min_overlap_length);
+        const __m128 min_olp = _mm_set1_ps(t.min_overlap_percentage);
+        const __m128 max_oh = _mm_set1_ps(t.max_overhang_length);
+        const __m128 max_ohp = _mm_set1_ps(t.max_overhang_percentage);
+        const __m128 half = _mm_set1_ps(0.5f);
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i q_len = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.query_len + i));
+            __m128i q_start = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.query_start + i));
+            __m128i q_end = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.query_end + i));
+            __m128i t_len = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.target_len + i));
+            __m128i t_start = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.target_start + i));
+            __m128i t_end = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.target_end + i));
+
+            __m128i q_ol = _mm_sub_epi32(q_end, q_start);
+            __m128i t_ol = _mm_sub_epi32(t_end, t_start);
+            __m128i q_oh = _mm_sub_epi32(q_len, q_end);
+            __m128i t_oh = t_start;
+
+            __m128 overlap, overhang, total;
+            switch (t.mode) {
+                case OverlapGraph::MIN:
+                    overlap = _mm_min_ps(_mm_cvtepi32_ps(q_ol), _mm_cvtepi32_ps(t_ol));
+                    overhang = _mm_min_ps(_mm_cvtepi32_ps(q_oh), _mm_cvtepi32_ps(t_oh));
+                    total = _mm_min_ps(_mm_cvtepi32_ps(q_len), _mm_cvtepi32_ps(t_len));
+                    break;
+                case OverlapGraph::MAX:
+                    overlap = _mm_max_ps(_mm_cvtepi32_ps(q_ol), _mm_cvtepi32_ps(t_ol));
+                    overhang = _mm_max_ps(_mm_cvtepi32_ps(q_oh), _mm_cvtepi32_ps(t_oh));
+                    total = _mm_max_ps(_mm_cvtepi32_ps(q_len), _mm_cvtepi32_ps(t_len));
+                    break;
+                case OverlapGraph::AVG:
+                    overlap = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(q_ol, t_ol)), half);
+                    overhang = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(q_oh, t_oh)), half);
+                    total = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(q_len, t_len)), half);
+                    break;
+                case OverlapGraph::SUM:
+                default:
+                    overlap = _mm_cvtepi32_ps(_mm_add_epi32(q_ol, t_ol));
+                    overhang = _mm_cvtepi32_ps(_mm_add_epi32(q_oh, t_oh));
+                    total = _mm_cvtepi32_ps(_mm_add_epi32(q_len, t_len));
+                    break;
+            }
+
+            __m128 fail[] = {
+                    _mm_cmplt_ps(overlap, min_ol),
+                    _mm_cmplt_ps(_mm_div_ps(overlap, total), min_olp),
+                    _mm_cmpnle_ps(overhang, max_oh),
+                    _mm_cmpnle_ps(_mm_div_ps(overhang, overlap), max_ohp)
+            };
+            for (int k = 0; k < 4; k++) {
+                failed[OverlapGraph::SHORT_OVERLAP + k][i / 64] |=
+                        static_cast<uint64_t>(_mm_movemask_ps(fail[k])) << (i % 64);
+            }
+        }
+        return i;
+    }
+
+    /** Evaluates records [0, n - n % 8) and returns the number evaluated. */
+    __attribute__((target("avx2")))
+    size_t filterAVX2(const Columns &c, const Thresholds &t, size_t n, FailMasks failed) {
+        const __m256 min_ol = _mm256_set1_ps(t.min_overlap_length);
+        const __m256 min_olp = _mm256_set1_ps(t.min_overlap_percentage);
+        const __m256 max_oh = _mm256_set1_ps(t.max_overhang_length);
+        const __m256 max_ohp = _mm256_set1_ps(t.max_overhang_percentage);
+        const __m256 half = _mm256_set1_ps(0.5f);
+
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i q_len = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c.query_len + i));
+            __m256i q_start = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c.query_start + i));
+            __m256i q_end = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c.query_end + i));
+            __m256i t_len = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c.target_len + i));
+            __m256i t_start = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c.target_start + i));
+            __m256i t_end = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c.target_end + i));
+
+            __m256i q_ol = _mm256_sub_epi32(q_end, q_start);
+            __m256i t_ol = _mm256_sub_epi32(t_end, t_start);
+            __m256i q_oh = _mm256_sub_epi32(q_len, q_end);
+            __m256i t_oh = t_start;
+
+            __m256 overlap, overhang, total;
+            switch (t.mode) {
+                case OverlapGraph::MIN:
+                    overlap = _mm256_min_ps(_mm256_cvtepi32_ps(q_ol), _mm256_cvtepi32_ps(t_ol));
+                    overhang = _mm256_min_ps(_mm256_cvtepi32_ps(q_oh), _mm256_cvtepi32_ps(t_oh));
+                    total = _mm256_min_ps(_mm256_cvtepi32_ps(q_len), _mm256_cvtepi32_ps(t_len));
+                    break;
+                case OverlapGraph::MAX:
+                    overlap = _mm256_max_ps(_mm256_cvtepi32_ps(q_ol), _mm256_cvtepi32_ps(t_ol));
+                    overhang = _mm256_max_ps(_mm256_cvtepi32_ps(q_oh), _mm256_cvtepi32_ps(t_oh));
+                    total = _mm256_max_ps(_mm256_cvtepi32_ps(q_len), _mm256_cvtepi32_ps(t_len));
+                    break;
+                case OverlapGraph::AVG:
+                    overlap = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(q_ol, t_ol)), half);
+                    overhang = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(q_oh, t_oh)), half);
+                    total = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(q_len, t_len)), half);
+                    break;
+                case OverlapGraph::SUM:
+                default:
+                    overlap = _mm256_cvtepi32_ps(_mm256_add_epi32(q_ol, t_ol));
+                    overhang = _mm256_cvtepi32_ps(_mm256_add_epi32(q_oh, t_oh));
+                    total = _mm256_cvtepi32_ps(_mm256_add_epi32(q_len, t_len));
+                    break;
+            }
+
+            __m256 fail[] = {
+                    _mm256_cmp_ps(overlap, min_ol, _CMP_LT_OQ),
+                    _mm256_cmp_ps(_mm256_div_ps(overlap, total), min_olp, _CMP_LT_OQ),
+                    _mm256_cmp_ps(overhang, max_oh, _CMP_NLE_UQ),
+                    _mm256_cmp_ps(_mm256_div_ps(overhang, overlap), max_ohp, _CMP_NLE_UQ)
+            };
+            for (int k = 0; k < 4; k++) {
+                failed[OverlapGraph::SHORT_OVERLAP + k][i / 64] |=
+                        static_cast<uint64_t>(_mm256_movemask_ps(fail[k])) << (i % 64);
+            }
+        }
+        return i;
+    }
+#endif
+
+    KernelFunction function(OverlapBatch::Kernel kernel) {
+        switch (kernel) {
+#ifdef TELOMERI_X86
+            case OverlapBatch::AVX2:
+                return filterAVX2;
+            case OverlapBatch::SSE2:
+                return filterSSE2;
+#endif
+            default:
+                return nullptr;
+        }
+    }
+}
+
+bool OverlapBatch::supported(Kernel kernel) {
+    switch (kernel) {
+#ifdef TELOMERI_X86
+        case AVX2:
+            return __builtin_cpu_supports("avx2");
+        case SSE2:
+            return __builtin_cpu_supports("sse2");
+#endif
+        case SCALAR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+OverlapBatch::Kernel OverlapBatch::best() {
+    static const Kernel kernel = supported(AVX2) ? AVX2 : supported(SSE2) ? SSE2 : SCALAR;
+    return kernel;
+}
+
+OverlapBatch::OverlapBatch() : mask_(CAPACITY / 64) {
+    for (std::vector<uint64_t> &f : failed_) {
+        f.resize(CAPACITY / 64);
+    }
+    records_.reserve(CAPACITY);
+    for (std::vector<int32_t> *column : {&query_len_, &query_start_, &query_end_,
+                                         &target_len_, &target_start_, &target_end_}) {
+        column->reserve(CAPACITY);
+    }
+}
+
+void OverlapBatch::push(const OverlapGraph::PAFOverlap &o) {
+    records_.push_back(o);
+    query_len_.push_back(o.query_len);
+    query_start_.push_back(o.query_start);
+    query_end_.push_back(o.query_end);
+    target_len_.push_back(o.target_len);
+    target_start_.push_back(o.target_start);
+    target_end_.push_back(o.target_end);
+}
+
+void OverlapBatch::clear() {
+    records_.clear();
+    for (std::vector<int32_t> *column : {&query_len_, &query_start_, &query_end_,
+                                         &target_len_, &target_start_, &target_end_}) {
+        column->clear();
+    }
+}
+
+size_t OverlapBatch::evaluate(const OverlapGraph &g) {
+    return evaluate(g, best());
+}
+
+size_t OverlapBatch::evaluate(const OverlapGraph &g, Kernel kernel) {
+    FailMasks failed;
+    for (int r = 0; r <= OverlapGraph::HIGH_OVERHANG_PERCENTAGE; r++) {
+        std::fill(failed_[r].begin(), failed_[r].end(), 0);
+        failed[r] = failed_[r].data();
+    }
+
+    size_t i = 0;
+    KernelFunction f = g.filter_params_.mode <= OverlapGraph::SUM ? function(kernel) : nullptr;
+    if (f) {
+        const OverlapGraph::FilterParameters &p = g.filter_params_;
+        Columns c{query_len_.data(), query_start_.data(), query_end_.data(),
+                  target_len_.data(), target_start_.data(), target_end_.data()};
+        Thresholds t{p.mode, static_cast<float>(p.min_overlap_length), p.min_overlap_percentage,
+                     static_cast<float>(p.max_overhang_length), p.max_overhang_percentage};
+        i = f(c, t, records_.size(), failed);
+    }
+
+    // Remainder that doesn't fill a vector, or all records with the scalar kernel.
+    for (; i < records_.size(); i++) {
+        OverlapGraph::FilterResult r = g.filter(records_[i]);
+        if (r != OverlapGraph::ACCEPTED) {
+            failed[r][i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+
+    // Attribute every rejected record to the first check it failed.
+    std::fill(std::begin(reject_counts_), std::end(reject_counts_), 0);
+    size_t passed = 0;
+    for (size_t w = 0; w < mask_.size(); w++) {
+        size_t valid = std::min<size_t>(64, records_.size() - std::min(records_.size(), w * 64));
+        uint64_t remaining = valid == 64 ? ~uint64_t(0) : (uint64_t(1) << valid) - 1;
+        for (int r = OverlapGraph::SHORT_OVERLAP; r <= OverlapGraph::HIGH_OVERHANG_PERCENTAGE; r++) {
+            uint64_t first = failed_[r][w] & remaining;
+            reject_counts_[r] += __builtin_popcountll(first);
+            remaining &= ~first;
+        }
+        mask_[w] = remaining;
+        passed += __builtin_popcountll(remaining);
+    }
+    return passed;
+}
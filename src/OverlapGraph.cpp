@@ -2,9 +2,26 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <glob.h>
+#include <sys/stat.h>
 
 #include <Utils.hpp>
+#include <MappedFile.hpp>
+#include <OverlapBatch.hpp>
+#include <InputSource.hpp>
+#include <PAFTokenizer.hpp>
+#include <Stopwatch.hpp>
 #include <cfloat>
+#include <cmath>
 #include <climits>
 
 int getQueryOverlapLength(const OverlapGraph::PAFOverlap &overlap);
@@ -21,6 +38,19 @@ int getTargetExtensionLength(const OverlapGraph::PAFOverlap &overlap);
 
 float getSequenceIdentity(const OverlapGraph::PAFOverlap &overlap);
 
+/** Size of the buffer used to read overlaps from standard input and pipes. */
+static const size_t STREAM_BUFFER_SIZE = 4 << 20;
+
+/** Number of bytes whose delimiters are located in a single tokenizer pass. */
+static const size_t TOKENIZE_BLOCK_SIZE = 256 << 10;
+
+/** Prints the summary line of a loaded file. */
+static void printLoaded(const LoadStats &stats, size_t total_edges) {
+    std::cout << "Loaded " << total_edges << '/' << stats.lines << " edges from " << stats.file
+              << " (" << stats.bytes / 1e6 << " MB, " << stats.bytesPerSecond() / 1e9 << " GB/s, "
+              << stats.earlyRejects() << " rejected early)" << std::endl;
+}
+
 std::string OverlapGraph::stats() {
     std::stringstream str;
 
@@ -33,17 +63,17 @@ std::string OverlapGraph::stats() {
             min_len = n.length;
         if (max_len < n.length)
             max_len = n.length;
-        if (min_con > n.edges.size())
-            min_con = n.edges.size();
-        if (max_con < n.edges.size())
-            max_con = n.edges.size();
+        if (min_con > edges(n).size())
+            min_con = edges(n).size();
+        if (max_con < edges(n).size())
+            max_con = edges(n).size();
     }
 
     ulong min_OL = ULONG_MAX, max_OL = 0;
     float min_OS = FLT_MAX, max_OS = 0;
     float min_ES = FLT_MAX, max_ES = 0;
     float min_SI = FLT_MAX, max_SI = 0;
-    for (const Edge &e:edges_) {
+    for (const Edge &e:adjacency_) { // Both orientations give the same values.
         if (min_OS > e.overlap_score) {
             min_OS = e.overlap_score;
         }
@@ -56,11 +86,11 @@ std::string OverlapGraph::stats() {
         if (max_ES < e.extension_score) {
             max_ES = e.extension_score;
         }
-        if (min_SI > e.sequence_identity) {
-            min_SI = e.sequence_identity;
+        if (min_SI > e.sequenceIdentity()) {
+            min_SI = e.sequenceIdentity();
         }
-        if (max_SI < e.sequence_identity) {
-            max_SI = e.sequence_identity;
+        if (max_SI < e.sequenceIdentity()) {
+            max_SI = e.sequenceIdentity();
         }
         int ol = std::max(e.q_end - e.q_start, e.t_end - e.t_start);
         if (min_OL > ol) {
@@ -80,7 +110,7 @@ std::string OverlapGraph::stats() {
         << "- min_con: " << min_con << '\n'
         << "- max_con: " << max_con << '\n'
         << "Edges" << '\n'
-        << "-   total: " << edges_.size() << '\n'
+        << "-   total: " << edgesNum() << '\n'
         << "-  min_OL: " << min_OL << '\n'
         << "-  max_OL: " << max_OL << '\n'
         << "-  min_OS: " << min_OS << '\n'
@@ -89,12 +119,290 @@ std::string OverlapGraph::stats() {
         << "-  max_ES: " << max_ES << '\n'
         << "-  min_SI: " << min_SI << '\n'
         << "-  max_SI: " << max_SI << '\n'
-        << std::endl;
+        << "-   bytes: " << bytesPerEdge() << " per edge\n";
+
+    if (!load_stats_.empty()) {
+        str << "Loading" << '\n';
+        loadStats().toStream(str);
+        for (const LoadStats &s : load_stats_) {
+            str << s.file << '\n';
+            s.toStream(str);
+        }
+    }
+    str << std::endl;
 
     return str.str();
 }
 
-bool OverlapGraph::load(char *filepath, bool anchors) {
+std::string OverlapGraph::statsJson() const {
+    std::stringstream str;
+    ulong anchors = 0;
+    for (const Node &n : nodes_) {
+        anchors += n.anchor;
+    }
+
+    str << "{\"nodes\": " << nodes_.size()
+        << ", \"anchors\": " << anchors
+        << ", \"edges\": " << edgesNum()
+        << ", \"bytes_per_edge\": " << bytesPerEdge()
+        << ", \"load\": ";
+    loadStats().toJson(str);
+    str << ", \"files\": [";
+    for (size_t i = 0; i < load_stats_.size(); i++) {
+        str << (i > 0 ? ", " : "");
+        load_stats_[i].toJson(str);
+    }
+    str << "]}";
+    return str.str();
+}
+
+double OverlapGraph::bytesPerEdge() const {
+    return edgesNum() > 0 ? static_cast<double>(adjacency_.capacity() * sizeof(Edge)) / edgesNum() : 0.0;
+}
+
+LoadStats OverlapGraph::loadStats() const {
+    LoadStats total;
+    for (const LoadStats &s : load_stats_) {
+        total.merge(s);
+    }
+    return total;
+}
+
+/** Returns true if the file is a regular uncompressed file, which can be
+ * memory-mapped. */
+static bool mappable(const char *filepath) {
+    struct stat st{};
+    return std::strcmp(filepath, "-") != 0 && stat(filepath, &st) == 0 && S_ISREG(st.st_mode)
+           && !InputSource::isCompressed(filepath);
+}
+
+bool OverlapGraph::load(const char *filepath, bool anchors) {
+    return buildLoaded(loadFile(filepath, anchors));
+}
+
+bool OverlapGraph::buildLoaded(bool ok) {
+    Stopwatch build_timer;
+    build_timer.start();
+    buildAdjacency();
+    if (ok && !load_stats_.empty()) {
+        double build_time = build_timer.stop();
+        load_stats_.back().build_time += build_time;
+        load_stats_.back().time += build_time;
+    }
+    return ok;
+}
+
+bool OverlapGraph::loadFile(const char *filepath, bool anchors) {
+    Stopwatch timer;
+    timer.start();
+
+    LoadStats stats;
+    stats.file = filepath;
+    size_t nodes = nodes_.size(), edges = edgesNum();
+    struct stat st{};
+    bool ok;
+    if (mappable(filepath) && stat(filepath, &st) == 0) {
+        stats.bytes = static_cast<ulong>(st.st_size);
+        ok = loader_mode_ == MMAP ?
+             loadMapped(filepath, anchors, stats) : loadStream(filepath, anchors, stats);
+    } else {
+        // Standard input and pipes are consumed while the producer is still
+        // writing, compressed files are decompressed while being parsed.
+        ok = loadBuffered(filepath, anchors, stats);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    stats.time = timer.stop();
+    stats.nodes = nodes_.size() - nodes;
+    stats.edges = edgesNum() - edges;
+    // Both names of an added edge are looked up, only new nodes miss.
+    stats.name_lookups = 2 * stats.edges;
+    stats.name_hits = stats.name_lookups - stats.nodes;
+    load_stats_.push_back(stats);
+    printLoaded(stats, edgesNum());
+    return true;
+}
+
+namespace {
+    /** Contents of one shard, parsed and filtered by a worker. */
+    struct Shard {
+        std::unique_ptr<MappedFile> mapping;
+        /** Shard cannot be mapped, it is streamed when merged instead. */
+        bool streamed = false;
+        std::string error;
+        LoadStats stats;
+        std::vector<std::pair<OverlapGraph::PAFOverlap, ContigPosition>> accepted;
+        std::promise<void> done;
+    };
+}
+
+bool OverlapGraph::load(const std::vector<std::string> &filepaths, bool anchors) {
+    if (filepaths.size() <= 1 || load_threads_ == 1 || loader_mode_ != MMAP || test_load_num_ > 0) {
+        // Edges of all files are collected first, so the adjacency is built once.
+        bool ok = true;
+        for (size_t i = 0; ok && i < filepaths.size(); i++) {
+            ok = loadFile(filepaths[i].c_str(), anchors);
+        }
+        return buildLoaded(ok);
+    }
+
+    Stopwatch timer;
+    timer.start();
+
+    // Workers take shards in order and wait while their shard is
+    // load_threads_ or more ahead of the merge below, so a slow shard
+    // doesn't leave all later ones in memory.
+    std::vector<Shard> shards(filepaths.size());
+    std::atomic<size_t> next{0};
+    std::mutex merge_mutex;
+    std::condition_variable merge_cv;
+    size_t merged = 0;
+    bool cancelled = false;
+    auto work = [&] {
+        for (size_t i; (i = next++) < shards.size();) {
+            {
+                std::unique_lock<std::mutex> lock(merge_mutex);
+                merge_cv.wait(lock, [&] { return cancelled || i < merged + load_threads_; });
+                if (cancelled) {
+                    break;
+                }
+            }
+            Shard &shard = shards[i];
+            Stopwatch shard_timer;
+            shard_timer.start();
+            const char *filepath = filepaths[i].c_str();
+            if (!mappable(filepath)) {
+                shard.streamed = true;
+            } else if (shard.mapping = std::make_unique<MappedFile>(filepath); !shard.mapping->valid()) {
+                shard.error = std::string("Cannot open file: ") + filepath;
+            } else {
+                const char *begin = shard.mapping->data();
+                shard.stats.bytes = shard.mapping->size();
+                const char *error = parseRange(begin, begin + shard.mapping->size(), anchors,
+                                               shard.stats, shard.accepted);
+                if (error) {
+                    shard.error = "Malformed PAF record at byte " + std::to_string(error - begin)
+                                  + " of " + filepath;
+                }
+            }
+            shard.stats.time = shard_timer.stop();
+            shard.done.set_value();
+        }
+    };
+    std::vector<std::future<void>> done;
+    for (Shard &shard : shards) {
+        done.push_back(shard.done.get_future());
+    }
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < std::min<size_t>(load_threads_, shards.size()); w++) {
+        workers.emplace_back(work);
+    }
+
+    // Merge in shard order, releasing every shard once its overlaps are added.
+    bool ok = true;
+    for (size_t i = 0; i < shards.size(); i++) {
+        done[i].wait();
+        Shard &shard = shards[i];
+        if (!shard.error.empty()) {
+            std::cerr << shard.error << std::endl;
+            ok = false;
+            break;
+        }
+        if (shard.streamed) {
+            // Pipes and compressed shards are parsed through a bounded buffer
+            // here, holding them whole could exhaust memory.
+            ok = loadFile(filepaths[i].c_str(), anchors);
+            if (!ok) {
+                break;
+            }
+        } else {
+            Stopwatch build_timer;
+            build_timer.start();
+            size_t nodes = nodes_.size(), edges = edgesNum();
+            for (const auto &a : shard.accepted) {
+                buildFrom(a.first, a.second);
+            }
+            LoadStats &stats = shard.stats;
+            stats.build_time = build_timer.stop();
+            stats.time += stats.build_time;
+            stats.file = filepaths[i];
+            stats.nodes = nodes_.size() - nodes;
+            stats.edges = edgesNum() - edges;
+            stats.name_lookups = 2 * stats.edges;
+            stats.name_hits = stats.name_lookups - stats.nodes;
+            load_stats_.push_back(stats);
+            printLoaded(stats, edgesNum());
+            shard = Shard();
+        }
+
+        // Let workers take the next shard.
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            merged = i + 1;
+        }
+        merge_cv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        cancelled = !ok;
+    }
+    merge_cv.notify_all();
+    for (std::thread &w : workers) {
+        w.join();
+    }
+    if (!ok) {
+        return buildLoaded(false);
+    }
+
+    // Shard times are the time of their worker, the slowest ones delay the
+    // merge. Taken before the adjacency build, which is added to the last one.
+    std::vector<double> times;
+    for (auto it = load_stats_.end() - filepaths.size(); it != load_stats_.end(); ++it) {
+        times.push_back(it->time);
+    }
+    auto slowest = std::max_element(load_stats_.end() - filepaths.size(), load_stats_.end(),
+                                    [](const LoadStats &a, const LoadStats &b) { return a.time < b.time; });
+    std::string slowest_file = slowest->file;
+    double slowest_time = slowest->time;
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    buildLoaded(true);
+    std::cout << "Loaded " << filepaths.size() << " shards in " << timer.stop() << "s, median shard "
+              << times[times.size() / 2] << "s, slowest " << slowest_file << ' ' << slowest_time << 's'
+              << std::endl;
+    return true;
+}
+
+bool OverlapGraph::expandShards(const char *pattern, std::vector<std::string> &filepaths) {
+    filepaths.clear();
+    if (pattern[0] == '@') {
+        std::ifstream list(pattern + 1);
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty()) {
+                filepaths.push_back(line);
+            }
+        }
+        return !list.bad() && !filepaths.empty();
+    }
+
+    glob_t matches;
+    int ret = glob(pattern, 0, nullptr, &matches);
+    if (ret == 0) {
+        filepaths.assign(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc); // Sorted by glob().
+    }
+    globfree(&matches);
+    if (ret == GLOB_NOMATCH && !std::strpbrk(pattern, "*?[")) {
+        filepaths.emplace_back(pattern); // Standard input, or a file that is reported missing when loaded.
+    }
+    return !filepaths.empty();
+}
+
+bool OverlapGraph::loadStream(const char *filepath, bool anchors, LoadStats &stats) {
+    Stopwatch timer;
+    timer.start();
+
     std::fstream filestream;
     filestream.open(filepath, std::fstream::in);
     if (!filestream) {
@@ -104,15 +412,15 @@ bool OverlapGraph::load(char *filepath, bool anchors) {
 
     // Read line-by-line, check filter and build nodes.
     PAFOverlap o;
-    std::string s;
-    ulong ctr = 0;
+    std::string query_name, target_name;
+    std::string tags;
     while (filestream
-            >> o.query_name
+            >> query_name
             >> o.query_len
             >> o.query_start
             >> o.query_end
             >> o.relative_strand
-            >> o.target_name
+            >> target_name
             >> o.target_len
             >> o.target_start
             >> o.target_end
@@ -120,44 +428,419 @@ bool OverlapGraph::load(char *filepath, bool anchors) {
             >> o.alignment_block_len
             >> o.mapping_quality) {
 
-        // Ignore these last 4 unspecified outputs.
-        filestream >> s;
-        filestream >> s;
-        filestream >> s;
-        filestream >> s;
-        ++ctr;
-
-        ContigPosition pos;
-        if (anchors) {
-            // Checks the position of the contig by checking name starts with 'ctg'.
-            // If none starts with this template, decision defaults to contig-read format.
-            pos = Utils::startsWithInsensitive(o.query_name, "ctg") ?
-                  ContigPosition::QUERY : ContigPosition::TARGET;
-        } else {
-            pos = ContigPosition::NONE;
+        // Any number of optional tags follows until the end of line.
+        std::getline(filestream, tags);
+        size_t tags_begin = std::min(tags.find_first_not_of(" \t"), tags.size());
+        size_t tags_end = tags.find_last_not_of(" \t\r") + 1;
+        o.tags = PAFTags(std::string_view(tags).substr(tags_begin, tags_end - tags_begin));
+        ++stats.lines;
+        if (query_name.size() > NameInterner::MAX_NAME_LENGTH || target_name.size() > NameInterner::MAX_NAME_LENGTH) {
+            std::cerr << "Malformed PAF record at line " << stats.lines << " of " << filepath << std::endl;
+            return false;
         }
 
-        if (filter(o)) {
-            buildFrom(o, pos);
+        if (filter_params_.skip_secondary && o.tags.secondary()) {
+            ++stats.secondary_rejects;
+        } else {
+            o.query_name = query_name;
+            o.target_name = target_name;
+            add(o, anchors, stats);
         }
 
         // When testing, load only N instances.
-        if (test_load_num_ > 0 && test_load_num_ < ctr) {
+        if (test_load_num_ > 0 && test_load_num_ < stats.lines) {
             break;
         }
     }
 
-    std::cout << "Loaded " << edges_.size() << '/' << ctr << " edges from " << filepath << std::endl;
-
     filestream.close();
+    stats.parse_time = timer.stop() - stats.filter_time - stats.build_time;
+    return true;
+}
+
+/** Parses a non-negative decimal integer. Returns false if field is not one
+ * or does not fit into an int. */
+static inline bool parseInt(std::string_view field, int &value) {
+    if (field.empty()) {
+        return false;
+    }
+    int v = 0;
+    for (char c : field) {
+        unsigned d = static_cast<unsigned>(c - '0');
+        if (d > 9 || v > (INT_MAX - static_cast<int>(d)) / 10) {
+            return false;
+        }
+        v = v * 10 + static_cast<int>(d);
+    }
+    value = v;
+    return true;
+}
+
+/** Outcome of parsing a single PAF line. */
+enum class ParseResult : char {
+    PARSED,
+    REJECTED, /**< Line was rejected before its fields were converted. */
+    MALFORMED
+};
+
+/** Parses the 12 mandatory columns of a PAF line and records the range of the
+ * optional tags. Fields are split first so secondary alignments can be
+ * rejected by their tag before any numeric conversion.
+ * @param tabs Offsets of the tabs in the line, relative to block. */
+static ParseResult parsePAFLine(const char *block, const char *begin, const char *end,
+                                const uint32_t *tabs, size_t tab_num,
+                                bool skip_secondary, OverlapGraph::PAFOverlap &o) {
+    std::string_view fields[12];
+    const char *cur = begin;
+    for (size_t i = 0; i < 12; i++) {
+        const char *field_end = i < tab_num ? block + tabs[i] : end;
+        fields[i] = std::string_view(cur, field_end - cur);
+        cur = i < tab_num ? field_end + 1 : end;
+    }
+    o.tags = PAFTags(std::string_view(cur, end - cur));
+    if (skip_secondary && o.tags.secondary()) {
+        return ParseResult::REJECTED;
+    }
+
+    o.query_name = fields[0];
+    o.target_name = fields[5];
+    o.relative_strand = fields[4].empty() ? '\0' : fields[4][0];
+    bool ok = parseInt(fields[1], o.query_len)
+              && parseInt(fields[2], o.query_start)
+              && parseInt(fields[3], o.query_end)
+              && parseInt(fields[6], o.target_len)
+              && parseInt(fields[7], o.target_start)
+              && parseInt(fields[8], o.target_end)
+              && parseInt(fields[9], o.residue_matches_num)
+              && parseInt(fields[10], o.alignment_block_len)
+              && parseInt(fields[11], o.mapping_quality);
+    ok = ok && o.query_name.size() <= NameInterner::MAX_NAME_LENGTH
+         && o.target_name.size() <= NameInterner::MAX_NAME_LENGTH;
+    return ok && fields[4].size() == 1 && !o.query_name.empty() && !o.target_name.empty() ?
+           ParseResult::PARSED : ParseResult::MALFORMED;
+}
+
+/** Returns the end of the block that starts at cur: the first line boundary
+ * after TOKENIZE_BLOCK_SIZE bytes, or end. */
+static const char *blockEnd(const char *cur, const char *end) {
+    if (static_cast<size_t>(end - cur) <= TOKENIZE_BLOCK_SIZE) {
+        return end;
+    }
+    const char *nl = static_cast<const char *>(memrchr(cur, '\n', TOKENIZE_BLOCK_SIZE));
+    if (!nl) { // Line longer than the block.
+        nl = static_cast<const char *>(std::memchr(cur + TOKENIZE_BLOCK_SIZE, '\n',
+                                                   end - cur - TOKENIZE_BLOCK_SIZE));
+    }
+    return nl ? nl + 1 : end;
+}
+
+/** Calls f for every record in [cur, end) until it returns false. Lines
+ * rejected while parsing are only counted in rejected. Returns pointer to the
+ * first malformed line, or nullptr if all lines were parsed. */
+template<typename F>
+static const char *forEachRecord(const char *cur, const char *end, bool skip_secondary, ulong &rejected, F &&f) {
+    OverlapGraph::PAFOverlap o;
+    std::vector<uint32_t> delimiters;
+    while (cur < end) {
+        // Locate all tabs and newlines of the block at once.
+        const char *block_end = blockEnd(cur, end);
+        size_t block_size = block_end - cur;
+        if (delimiters.size() < block_size) {
+            delimiters.resize(block_size);
+        }
+        size_t delimiter_num = PAFTokenizer::scan(cur, block_size, delimiters.data());
+
+        size_t first_tab = 0; // Index of the first delimiter of the current line.
+        for (size_t i = 0; i <= delimiter_num; i++) {
+            if (i < delimiter_num && cur[delimiters[i]] == '\t') {
+                continue;
+            }
+
+            // Delimiters from first_tab to i are the tabs of the line.
+            const char *line_begin = first_tab > 0 ? cur + delimiters[first_tab - 1] + 1 : cur;
+            const char *line_end = i < delimiter_num ? cur + delimiters[i] : block_end;
+            if (line_end > line_begin && line_end[-1] == '\r') {
+                --line_end;
+            }
+
+            if (line_end > line_begin) { // Skip empty lines.
+                ParseResult r = parsePAFLine(cur, line_begin, line_end, delimiters.data() + first_tab,
+                                             std::min<size_t>(i - first_tab, 12), skip_secondary, o);
+                if (r == ParseResult::MALFORMED) {
+                    return line_begin;
+                }
+                if (r == ParseResult::REJECTED) {
+                    ++rejected;
+                } else if (!f(o)) {
+                    return nullptr;
+                }
+            }
+            first_tab = i + 1;
+        }
+
+        cur = block_end;
+    }
+    return nullptr;
+}
+
+/** Decides if and where the contig is in the overlap. */
+static ContigPosition contigPosition(const OverlapGraph::PAFOverlap &overlap, bool anchors) {
+    if (!anchors) {
+        return ContigPosition::NONE;
+    }
+    // Checks the position of the contig by checking name starts with 'ctg'.
+    // If none starts with this template, decision defaults to contig-read format.
+    return Utils::startsWithInsensitive(overlap.query_name, "ctg") ?
+           ContigPosition::QUERY : ContigPosition::TARGET;
+}
+
+bool OverlapGraph::loadMapped(const char *filepath, bool anchors, LoadStats &stats) {
+    MappedFile file(filepath);
+    if (!file.valid()) {
+        std::cerr << "Cannot open file: " << filepath << std::endl;
+        return false;
+    }
+
+    const char *begin = file.data();
+    const char *end = begin + file.size();
+    const char *error;
+    if (load_threads_ > 1 && test_load_num_ == 0) {
+        error = loadChunks(begin, end, anchors, stats);
+    } else {
+        Stopwatch timer;
+        timer.start();
+        OverlapBatch batch;
+        error = forEachRecord(begin, end, filter_params_.skip_secondary, stats.secondary_rejects,
+                              [&](const PAFOverlap &o) {
+            ++stats.lines;
+            batch.push(o);
+            if (batch.full()) {
+                addBatch(batch, anchors, stats);
+            }
+
+            // When testing, load only N instances.
+            return !(test_load_num_ > 0 && test_load_num_ < stats.lines);
+        });
+        addBatch(batch, anchors, stats);
+        stats.lines += stats.secondary_rejects;
+        stats.parse_time = timer.stop() - stats.filter_time - stats.build_time;
+    }
+
+    if (error) {
+        std::cerr << "Malformed PAF record at byte " << error - begin << " of " << filepath << std::endl;
+        return false;
+    }
     return true;
 }
 
-bool OverlapGraph::filter(const OverlapGraph::PAFOverlap &overlap) const {
-    if (overlap.query_name == overlap.target_name) { // Skip edges to the same starting point.
+bool OverlapGraph::loadBuffered(const char *filepath, bool anchors, LoadStats &stats) {
+    Stopwatch timer;
+    timer.start();
+
+    std::unique_ptr<InputSource> in = InputSource::open(filepath, load_threads_);
+    if (!in) {
+        std::cerr << "Cannot open file: " << filepath << std::endl;
         return false;
     }
 
+    std::vector<char> buffer(STREAM_BUFFER_SIZE);
+    OverlapBatch batch;
+    size_t filled = 0; // Unprocessed bytes at the start of the buffer.
+    ulong lines = 0, rejected = 0;
+    bool eof = false, stop = false;
+    while (!eof && !stop) {
+        if (filled == buffer.size()) { // Line longer than the buffer.
+            buffer.resize(buffer.size() * 2);
+        }
+        Stopwatch read_timer;
+        read_timer.start();
+        long r = in->read(buffer.data() + filled, buffer.size() - filled);
+        stats.read_time += read_timer.stop();
+        if (r < 0) {
+            std::cerr << "Cannot read file: " << filepath << std::endl;
+            return false;
+        }
+        eof = r == 0;
+        filled += r;
+        stats.bytes += r;
+
+        // Process complete lines, keep the trailing partial line for the next read.
+        const char *begin = buffer.data();
+        const char *end = begin + filled;
+        if (!eof) {
+            const char *last_nl = static_cast<const char *>(memrchr(begin, '\n', filled));
+            end = last_nl ? last_nl + 1 : begin;
+        }
+
+        const char *error = forEachRecord(begin, end, filter_params_.skip_secondary, rejected,
+                                          [&](const PAFOverlap &o) {
+            ++lines;
+            batch.push(o);
+            if (batch.full()) {
+                addBatch(batch, anchors, stats);
+            }
+
+            // When testing, load only N instances.
+            stop = test_load_num_ > 0 && test_load_num_ < lines;
+            return !stop;
+        });
+        addBatch(batch, anchors, stats); // Records point into the buffer, add them before it is moved.
+        if (error) {
+            std::cerr << "Malformed PAF record at byte " << stats.bytes - filled + (error - begin)
+                      << " of " << filepath << std::endl;
+            return false;
+        }
+
+        filled -= end - begin;
+        std::memmove(buffer.data(), end, filled);
+    }
+
+    stats.lines = lines + rejected;
+    stats.secondary_rejects = rejected;
+    stats.parse_time = timer.stop() - stats.filter_time - stats.build_time - stats.read_time;
+    return true;
+}
+
+/** Adds the reject counts of the last batch evaluation to the statistics. */
+static void countRejects(const OverlapBatch &batch, LoadStats &stats) {
+    stats.overlap_length_rejects += batch.rejected(OverlapGraph::SHORT_OVERLAP);
+    stats.overlap_percentage_rejects += batch.rejected(OverlapGraph::LOW_OVERLAP_PERCENTAGE);
+    stats.overhang_length_rejects += batch.rejected(OverlapGraph::LONG_OVERHANG);
+    stats.overhang_percentage_rejects += batch.rejected(OverlapGraph::HIGH_OVERHANG_PERCENTAGE);
+}
+
+const char *OverlapGraph::parseRange(const char *begin, const char *end, bool anchors, LoadStats &stats,
+                                     AcceptedOverlaps &accepted) const {
+    Stopwatch timer;
+    timer.start();
+    OverlapBatch batch;
+    auto flush = [&] {
+        Stopwatch filter_timer;
+        filter_timer.start();
+        batch.evaluate(*this);
+        stats.filter_time += filter_timer.stop();
+        countRejects(batch, stats);
+        batch.forEachPassed([&](const PAFOverlap &o) {
+            if (o.query_name == o.target_name) { // Skip edges to the same starting point.
+                ++stats.self_rejects;
+            } else {
+                accepted.emplace_back(o, contigPosition(o, anchors));
+            }
+        });
+        batch.clear();
+    };
+
+    const char *error = forEachRecord(begin, end, filter_params_.skip_secondary, stats.secondary_rejects,
+                                      [&](const PAFOverlap &o) {
+        ++stats.lines;
+        batch.push(o);
+        if (batch.full()) {
+            flush();
+        }
+        return true;
+    });
+    flush();
+    stats.lines += stats.secondary_rejects;
+    stats.parse_time += timer.stop() - stats.filter_time;
+    return error;
+}
+
+const char *OverlapGraph::loadChunks(const char *begin, const char *end, bool anchors, LoadStats &stats) {
+    struct Chunk {
+        const char *begin, *end;
+        const char *error = nullptr;
+        LoadStats stats;
+        AcceptedOverlaps accepted;
+    };
+
+    // Split into roughly equal chunks, moving each boundary past the next newline.
+    std::vector<Chunk> chunks(load_threads_);
+    const char *cur = begin;
+    for (uint i = 0; i < load_threads_; i++) {
+        const char *chunk_end = std::max(cur, begin + (end - begin) * (i + 1) / load_threads_);
+        const char *nl = static_cast<const char *>(std::memchr(chunk_end, '\n', end - chunk_end));
+        chunk_end = nl ? nl + 1 : end;
+        chunks[i].begin = cur;
+        chunks[i].end = chunk_end;
+        cur = chunk_end;
+    }
+
+    // Parse and filter in parallel. Accepted records keep views into the mapping.
+    std::vector<std::thread> workers;
+    for (Chunk &c : chunks) {
+        workers.emplace_back([this, &c, anchors] {
+            c.error = parseRange(c.begin, c.end, anchors, c.stats, c.accepted);
+        });
+    }
+    for (std::thread &w : workers) {
+        w.join();
+    }
+
+    // Merge in file order so node and edge order match the sequential load.
+    Stopwatch timer;
+    timer.start();
+    for (Chunk &c : chunks) {
+        if (c.error) {
+            return c.error;
+        }
+        stats.merge(c.stats);
+        for (const auto &a : c.accepted) {
+            buildFrom(a.first, a.second);
+        }
+    }
+    stats.build_time += timer.stop();
+    return nullptr;
+}
+
+void OverlapGraph::addBatch(OverlapBatch &batch, bool anchors, LoadStats &stats) {
+    Stopwatch timer;
+    timer.start();
+    batch.evaluate(*this);
+    stats.filter_time += timer.lap();
+    countRejects(batch, stats);
+
+    batch.forEachPassed([&](const PAFOverlap &overlap) {
+        if (overlap.query_name == overlap.target_name) { // Skip edges to the same starting point.
+            ++stats.self_rejects;
+        } else {
+            buildFrom(overlap, contigPosition(overlap, anchors));
+        }
+    });
+    stats.build_time += timer.lap();
+    batch.clear();
+}
+
+void OverlapGraph::add(const OverlapGraph::PAFOverlap &overlap, bool anchors, LoadStats &stats) {
+    Stopwatch timer;
+    timer.start();
+    FilterResult result = filter(overlap);
+    stats.filter_time += timer.lap();
+
+    switch (result) {
+        case ACCEPTED:
+            if (overlap.query_name == overlap.target_name) { // Skip edges to the same starting point.
+                ++stats.self_rejects;
+            } else {
+                buildFrom(overlap, contigPosition(overlap, anchors));
+                stats.build_time += timer.lap();
+            }
+            break;
+        case SHORT_OVERLAP:
+            ++stats.overlap_length_rejects;
+            break;
+        case LOW_OVERLAP_PERCENTAGE:
+            ++stats.overlap_percentage_rejects;
+            break;
+        case LONG_OVERHANG:
+            ++stats.overhang_length_rejects;
+            break;
+        case HIGH_OVERHANG_PERCENTAGE:
+            ++stats.overhang_percentage_rejects;
+            break;
+    }
+}
+
+OverlapGraph::FilterResult OverlapGraph::filter(const OverlapGraph::PAFOverlap &overlap) const {
     int query_overlap_length = getQueryOverlapLength(overlap);
     int target_overlap_length = getTargetOverlapLength(overlap);
     int query_overhang_length = getQueryOverhangLength(overlap);
@@ -189,32 +872,37 @@ bool OverlapGraph::filter(const OverlapGraph::PAFOverlap &overlap) const {
             total_length = overlap.query_len + overlap.target_len;
             break;
         default:
-            return false;
+            return SHORT_OVERLAP; // Unknown mode, nothing is usable.
     }
 
-    if (overlap_length < filter_params_.min_overlap_length
-        || (overlap_length / total_length) < filter_params_.min_overlap_percentage) {
-        return false;
+    if (overlap_length < filter_params_.min_overlap_length) {
+        return SHORT_OVERLAP;
     }
-
-    return overhang_length <= filter_params_.max_overhang_length
-           && (overhang_length / overlap_length) <= filter_params_.max_overhang_percentage;
+    if ((overlap_length / total_length) < filter_params_.min_overlap_percentage) {
+        return LOW_OVERLAP_PERCENTAGE;
+    }
+    if (!(overhang_length <= filter_params_.max_overhang_length)) {
+        return LONG_OVERHANG;
+    }
+    if (!((overhang_length / overlap_length) <= filter_params_.max_overhang_percentage)) {
+        return HIGH_OVERHANG_PERCENTAGE;
+    }
+    return ACCEPTED;
 }
 
 void OverlapGraph::buildFrom(
         const OverlapGraph::PAFOverlap &overlap,
         ContigPosition pos) {
 
-    long qn_index = nodeIndex(overlap.query_name);
-    if (qn_index < 0) { // Node doesn't exist yet, create it.
-        qn_index = nodes_.size();
-        nodes_.emplace_back(pos == ContigPosition::QUERY, qn_index, overlap.query_len, overlap.query_name);
+    bool inserted;
+    uint qn_index = names_.intern(overlap.query_name, inserted);
+    if (inserted) { // Node doesn't exist yet, create it.
+        nodes_.emplace_back(pos == ContigPosition::QUERY, qn_index, overlap.query_len);
     }
 
-    long tn_index = nodeIndex(overlap.target_name);
-    if (tn_index < 0) { // Node doesn't exist yet, create it.
-        tn_index = nodes_.size();
-        nodes_.emplace_back(pos == ContigPosition::TARGET, tn_index, overlap.target_len, overlap.target_name);
+    uint tn_index = names_.intern(overlap.target_name, inserted);
+    if (inserted) { // Node doesn't exist yet, create it.
+        nodes_.emplace_back(pos == ContigPosition::TARGET, tn_index, overlap.target_len);
     }
 
     // Create edge and emplace it into internal vector.
@@ -232,66 +920,119 @@ void OverlapGraph::buildFrom(
 
     Edge e(
             qn_index, // Index of first node of the edge.
-            tn_index, // Index of second node of the edge.
             overlap.query_start,
             overlap.query_end,
             overlap.target_start,
             overlap.target_end,
             OS, SI, ES, overlap.relative_strand=='-');
-    edges_.push_back(e);
+    pending_.push_back({tn_index, e}); // Stored at the second node of the edge.
+}
 
-    nodes_[tn_index].edges.push_back(e);
+void OverlapGraph::buildAdjacency() {
+    if (pending_.empty() && offsets_.size() == nodes_.size() + 1) {
+        return;
+    }
 
-    std::swap(e.q_index, e.t_index);
-    std::swap(e.q_start, e.t_start);
-    std::swap(e.q_end, e.t_end);
-    nodes_[qn_index].edges.push_back(e);
+    // Degree of every node after the merge. Nodes created by this load have
+    // no existing edges.
+    const size_t old_nodes = offsets_.size() - 1;
+    std::vector<ulong> offsets(nodes_.size() + 1, 0);
+    for (size_t i = 0; i < old_nodes; i++) {
+        offsets[i + 1] = offsets_[i + 1] - offsets_[i];
+    }
+    for (const PendingEdge &p : pending_) {
+        offsets[p.t_index + 1]++;
+        offsets[p.edge.q_index + 1]++;
+    }
+    for (size_t i = 1; i < offsets.size(); i++) {
+        offsets[i] += offsets[i - 1];
+    }
+
+    // Grow the adjacency in place and move the existing edges of every node
+    // to its new start. Runs only move towards the end, so the last node goes
+    // first. Appended edges are placeholders until they are filled below.
+    adjacency_.reserve(offsets.back());
+    while (adjacency_.size() < offsets.back()) {
+        adjacency_.push_back(pending_.front().edge);
+    }
+    std::vector<ulong> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = old_nodes; i-- > 0;) {
+        std::move_backward(adjacency_.begin() + offsets_[i], adjacency_.begin() + offsets_[i + 1],
+                           adjacency_.begin() + offsets[i] + (offsets_[i + 1] - offsets_[i]));
+        fill[i] += offsets_[i + 1] - offsets_[i];
+    }
+
+    // New edges follow the existing ones of both of their nodes, in load order.
+    for (const PendingEdge &p : pending_) {
+        adjacency_[fill[p.t_index]++] = Edge(p.edge);
+        adjacency_[fill[p.edge.q_index]++] = p.edge.reversed(p.t_index);
+    }
+
+    offsets_ = std::move(offsets);
+    pending_.clear();
+    pending_.shrink_to_fit();
+    buildAnchorIndex();
 }
 
-long OverlapGraph::nodeIndex(const std::string &name) const {
-    for (long i = nodes_.size() - 1; i >= 0; i--) {
-        if (nodes_[i].name == name) {
-            return i;
+void OverlapGraph::buildAnchorIndex() {
+    anchor_slots_.clear();
+    anchor_offsets_.assign(1, 0);
+    anchor_offsets_.reserve(nodes_.size() + 1);
+    for (Node &n : nodes_) {
+        for (ulong k = offsets_[n.index]; k < offsets_[n.index + 1]; k++) {
+            if (nodes_[adjacency_[k].q_index].anchor) {
+                anchor_slots_.push_back(k);
+            }
         }
+        n.touches_anchor = anchor_slots_.size() > anchor_offsets_.back();
+        anchor_offsets_.push_back(anchor_slots_.size());
     }
-    return -1;
 }
 
-OverlapGraph::Node::Node(bool anchor, uint index, uint length, const std::string &name)
-        : anchor(anchor), index(index), length(length), name(name) {}
+OverlapGraph::Node::Node(bool anchor, uint index, uint length)
+        : index(index), length(length), anchor(anchor) {}
 
 
 bool OverlapGraph::Node::operator==(const Node &rhs) const {
-    return name == rhs.name;
+    // Names are interned, so equal names share the node index.
+    return index == rhs.index;
 }
 
-void OverlapGraph::Node::to_stream(std::ostream &s) const {
+void OverlapGraph::Node::to_stream(std::ostream &s, const OverlapGraph &g) const {
     s << (anchor ? '*' : ' ') << 'n' << index << "  len: " << length
-      << "  name: " << name << "  edges: " << edges.size() << std::endl;
+      << "  name: " << g.name(*this) << "  edges: " << g.edges(*this).size() << std::endl;
 }
 
-OverlapGraph::Edge::Edge(uint q_index, uint t_index, uint q_start, uint q_end, uint t_start, uint t_end,
+OverlapGraph::Edge::Edge(uint q_index, uint q_start, uint q_end, uint t_start, uint t_end,
                          float overlap_score, float sequence_identity, float extension_score, bool relative_strand)
-        : q_index(q_index), t_index(t_index), q_start(q_start), q_end(q_end), t_start(t_start), t_end(t_end),
-          overlap_score(overlap_score), sequence_identity(sequence_identity),
-          extension_score(extension_score), relative_strand(relative_strand) {}
+        : q_index(q_index), q_start(q_start), q_end(q_end), t_start(t_start), t_end(t_end),
+          overlap_score(overlap_score), extension_score(extension_score),
+          identity_(static_cast<uint16_t>(std::lround(std::clamp(sequence_identity, 0.0f, 1.0f) * IDENTITY_MASK)
+                                          | (relative_strand ? STRAND_BIT : 0))) {}
 
 OverlapGraph::Edge &OverlapGraph::Edge::operator=(OverlapGraph::Edge &&e) noexcept {
     std::swap(q_index, e.q_index);
-    std::swap(t_index, e.t_index);
     std::swap(q_start, e.q_start);
     std::swap(q_end, e.q_end);
     std::swap(t_start, e.t_start);
     std::swap(t_end, e.t_end);
     std::swap(overlap_score, e.overlap_score);
-    std::swap(sequence_identity, e.sequence_identity);
     std::swap(extension_score, e.extension_score);
+    std::swap(identity_, e.identity_);
     return *this;
 }
 
+OverlapGraph::Edge OverlapGraph::Edge::reversed(uint t_index) const {
+    Edge e(*this);
+    e.q_index = t_index;
+    std::swap(e.q_start, e.t_start);
+    std::swap(e.q_end, e.t_end);
+    return e;
+}
+
 void OverlapGraph::Edge::to_stream(std::ostream &s) const {
-    s << q_index << "-" << t_index << "  OS: " << overlap_score
-      << "  ES: " << extension_score << "  SI: " << sequence_identity << std::endl;
+    s << "-n" << q_index << "  OS: " << overlap_score
+      << "  ES: " << extension_score << "  SI: " << sequenceIdentity() << std::endl;
 }
 
 int getQueryOverlapLength(const OverlapGraph::PAFOverlap &overlap) {
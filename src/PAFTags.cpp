@@ -0,0 +1,52 @@
+#include <PAFTags.hpp>
+
+#include <charconv>
+#include <cstring>
+
+bool PAFTags::find(std::string_view key, char &type, std::string_view &value) const {
+    const char *cur = raw_.data();
+    const char *end = cur + raw_.size();
+    while (cur < end) {
+        const char *tab = static_cast<const char *>(std::memchr(cur, '\t', end - cur));
+        const char *tag_end = tab ? tab : end;
+
+        // Tag is formatted as XX:T:VALUE.
+        if (tag_end - cur >= 5 && cur[0] == key[0] && cur[1] == key[1] && cur[2] == ':' && cur[4] == ':') {
+            type = cur[3];
+            value = std::string_view(cur + 5, tag_end - cur - 5);
+            return true;
+        }
+
+        cur = tag_end + 1;
+    }
+    return false;
+}
+
+char PAFTags::type() const {
+    char type;
+    std::string_view value;
+    if (!find("tp", type, value) || type != 'A' || value.size() != 1) {
+        return '\0';
+    }
+    return value[0];
+}
+
+bool PAFTags::getInt(std::string_view key, int &value) const {
+    char type;
+    std::string_view v;
+    if (!find(key, type, v) || type != 'i') {
+        return false;
+    }
+    std::from_chars_result r = std::from_chars(v.data(), v.data() + v.size(), value);
+    return r.ec == std::errc() && r.ptr == v.data() + v.size();
+}
+
+bool PAFTags::getFloat(std::string_view key, float &value) const {
+    char type;
+    std::string_view v;
+    if (!find(key, type, v) || type != 'f') {
+        return false;
+    }
+    std::from_chars_result r = std::from_chars(v.data(), v.data() + v.size(), value);
+    return r.ec == std::errc() && r.ptr == v.data() + v.size();
+}
@@ -0,0 +1,105 @@
+#include <PAFTokenizer.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TELOMERI_X86
+
+#include <immintrin.h>
+#endif
+
+namespace {
+    typedef size_t (*ScanFunction)(const char *, size_t, uint32_t *);
+
+    /** Scans data[0, n) byte by byte, offsets are reported relative to data - base. */
+    size_t scanScalar(const char *data, size_t n, uint32_t *out, size_t base) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (data[i] == '\t' || data[i] == '\n') {
+                out[count++] = static_cast<uint32_t>(base + i);
+            }
+        }
+        return count;
+    }
+
+    size_t scanScalar(const char *data, size_t n, uint32_t *out) {
+        return scanScalar(data, n, out, 0);
+    }
+
+    /** Appends the positions of set bits in mask, offset by base. */
+    inline size_t emitMask(uint32_t mask, size_t base, uint32_t *out) {
+        size_t count = 0;
+        while (mask) {
+            out[count++] = static_cast<uint32_t>(base + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+        return count;
+    }
+
+#ifdef TELOMERI_X86
+    size_t scanSSE2(const char *data, size_t n, uint32_t *out) {
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i nl = _mm_set1_epi8('\n');
+        size_t count = 0, i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, nl));
+            count += emitMask(static_cast<uint32_t>(_mm_movemask_epi8(hits)), i, out + count);
+        }
+        return count + scanScalar(data + i, n - i, out + count, i);
+    }
+
+    __attribute__((target("avx2")))
+    size_t scanAVX2(const char *data, size_t n, uint32_t *out) {
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i nl = _mm256_set1_epi8('\n');
+        size_t count = 0, i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(v, tab), _mm256_cmpeq_epi8(v, nl));
+            count += emitMask(static_cast<uint32_t>(_mm256_movemask_epi8(hits)), i, out + count);
+        }
+        return count + scanScalar(data + i, n - i, out + count, i);
+    }
+#endif
+
+    ScanFunction function(PAFTokenizer::Kernel kernel) {
+        switch (kernel) {
+#ifdef TELOMERI_X86
+            case PAFTokenizer::AVX2:
+                return scanAVX2;
+            case PAFTokenizer::SSE2:
+                return scanSSE2;
+#endif
+            default:
+                return scanScalar;
+        }
+    }
+}
+
+bool PAFTokenizer::supported(Kernel kernel) {
+    switch (kernel) {
+#ifdef TELOMERI_X86
+        case AVX2:
+            return __builtin_cpu_supports("avx2");
+        case SSE2:
+            return __builtin_cpu_supports("sse2");
+#endif
+        case SCALAR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+PAFTokenizer::Kernel PAFTokenizer::best() {
+    static const Kernel kernel = supported(AVX2) ? AVX2 : supported(SSE2) ? SSE2 : SCALAR;
+    return kernel;
+}
+
+size_t PAFTokenizer::scan(const char *data, size_t n, uint32_t *out) {
+    static const ScanFunction scan_best = function(best());
+    return scan_best(data, n, out);
+}
+
+size_t PAFTokenizer::scan(const char *data, size_t n, uint32_t *out, Kernel kernel) {
+    return function(kernel)(data, n, out);
+}
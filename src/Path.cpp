@@ -11,7 +11,33 @@ void Path::updateLength() {
 
     length_ = nodes_[0]->length;
     for (uint i = 1; i < edges_.size(); i++) {
-        length_ += edges_[i - 1]->q_start - (long) edges_[i - 1]->t_start;
+        length_ += edges_[i - 1]->lengthContribution();
+    }
+}
+
+
+void Path::start(const OverlapGraph::Node *node) {
+    nodes_.assign(1, node);
+    edges_.clear();
+    length_ = node->length;
+}
+
+
+void Path::push(const OverlapGraph::Edge *edge, const OverlapGraph::Node *node) {
+    // The last edge doesn't count, so the one it follows starts counting.
+    if (!edges_.empty()) {
+        length_ += edges_.back()->lengthContribution();
+    }
+    edges_.push_back(edge);
+    nodes_.push_back(node);
+}
+
+
+void Path::pop() {
+    edges_.pop_back();
+    nodes_.pop_back();
+    if (!edges_.empty()) {
+        length_ -= edges_.back()->lengthContribution();
     }
 }
 
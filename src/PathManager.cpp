@@ -1,389 +1,296 @@
 #include <PathManager.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <iomanip>
+#include <iterator>
+#include <numeric>
 #include <bitset>
 #include <set>
 #include <random>
 
+#include <EdgeOrder.hpp>
+#include <EdgeSampler.hpp>
 #include <PathWindow.hpp>
+#include <TaskScheduler.hpp>
 
 
+/** Prints how long every worker was busy, so an idle tail stands out. */
+static void printBusyTimes(const TaskScheduler &scheduler) {
+    const std::vector<double> &busy = scheduler.busyTimes();
+    if (busy.size() < 2) {
+        return;
+    }
+    std::cout << "Worker busy time:";
+    for (double t : busy) {
+        std::cout << ' ' << t << 's';
+    }
+    double mean = std::accumulate(busy.begin(), busy.end(), 0.0) / busy.size();
+    std::cout << " (slowest/mean " << (mean > 0 ? *std::max_element(busy.begin(), busy.end()) / mean : 1.0)
+              << ", " << scheduler.steals() << " steals)" << std::endl;
+}
+
 void PathManager::buildMonteCarlo(const OverlapGraph &g, const Utils::Metrics &metric) {
-    std::mt19937 gen;
-    std::uniform_real_distribution<> dis(0., 1.);
+    Utils::dispatchMetric(metric, [&](auto m) { buildMonteCarlo<decltype(m)::value>(g); });
+}
 
-    std::cout << "> Monte Carlo heuristic: " << Utils::getMetricName(metric) << std::endl;
-    ulong found = 0;
+template<Utils::Metrics M>
+void PathManager::buildMonteCarlo(const OverlapGraph &g) {
+    const EdgeSampler sampler(g, M);
 
-    // For each anchor-node as starting point.
+    std::cout << "> Monte Carlo heuristic: " << Utils::getMetricName(M) << std::endl;
+
+    // Every anchor is a task, its rebuild attempts are the steps.
+    std::vector<const OverlapGraph::Node *> anchors;
     for (const OverlapGraph::Node &start_node : g.nodes_) {
         // Skip read-nodes.
-        if (!start_node.anchor) {
-            continue;
+        if (start_node.anchor) {
+            anchors.push_back(&start_node);
         }
+    }
 
-//        std::cout << "---> Building from node n" << start_node.index << std::endl;
-
-        // Repeat path building from this starting point.
-        for (int r = 0; r < params_.rebuild_attempts; r++) {
-            const OverlapGraph::Node *n = &start_node;
-            Path p;
-            std::vector<bool> visited_nodes(g.nodes_.size(), false);
-            visited_nodes[n->index] = true;
-
-//            std::cout << "...... Run " << (r + 1) << '/' << REBUILD_ATTEMPTS
-//                      << "  (" << found << " found)" << std::endl;
-
-            // Store the starting node.
-            p.nodes_.push_back(n);
-
-            // Defines will the path be added (considered).
-            bool acceptable = false;
-
-            // Backtrack counter.
-            int backtracks = 0;
-
-            // Construct the path.
-            while (true) {
-                // Sum-up the metric values.
-                double sum = 0;
-                const OverlapGraph::Edge *anchor_edge = nullptr;
-                std::vector<const OverlapGraph::Edge *> appropriate_edges;
-                for (const OverlapGraph::Edge &e : n->edges) {
-                    const OverlapGraph::Node *q_n = &(g.nodes_[e.q_index]);
+    // Workers walk into their own scratch path and keep a found path only if
+    // it differs from the one found by the attempt before, as filterUnique()
+    // would drop it. Each worker has its own cache line for the counters.
+    struct Found {
+        size_t task;
+        uint attempt;
+        Path path;
+    };
+    struct alignas(64) Worker {
+        VisitedSet visited;
+        Path scratch;
+        std::vector<Found> found;
+        ulong walks_found = 0, scans = 0;
+        /** Last attempt walked, and whether found.back() follows it without
+         * a gap of attempts walked by other workers. */
+        size_t task = SIZE_MAX;
+        uint attempt = 0;
+        bool in_run = false;
+    };
+    TaskScheduler scheduler(params_.threads);
+    std::vector<Worker> workers(scheduler.threads());
+    for (Worker &w : workers) {
+        w.visited = VisitedSet(g.nodes_.size());
+    }
+    scheduler.run(std::vector<uint>(anchors.size(), params_.rebuild_attempts),
+                  [&](size_t task, uint attempt, uint worker) {
+                      // Streams only depend on the seed, anchor and attempt, not on the thread.
+                      const OverlapGraph::Node &start_node = *anchors[task];
+                      RandomStream gen(params_.seed, start_node.index, attempt);
+                      Worker &w = workers[worker];
+                      w.in_run = w.in_run && w.task == task && w.attempt + 1 == attempt;
+                      w.task = task;
+                      w.attempt = attempt;
+                      w.visited.clear();
+                      if (walkMonteCarlo<M>(g, sampler, start_node, gen, w.visited, w.scans, w.scratch)) {
+                          ++w.walks_found;
+                          if (!w.in_run || !(w.found.back().path == w.scratch)) {
+                              w.found.push_back({task, attempt, w.scratch});
+                          }
+                          w.in_run = true;
+                      }
+                  });
+
+    // Merge in anchor and attempt order, the same for any number of threads.
+    // Duplicates split between workers are dropped here.
+    std::vector<Found> found;
+    ulong found_num = 0, scanned = 0;
+    for (Worker &w : workers) {
+        std::move(w.found.begin(), w.found.end(), std::back_inserter(found));
+        w.found = std::vector<Found>();
+        found_num += w.walks_found;
+        scanned += w.scans;
+    }
+    std::sort(found.begin(), found.end(), [](const Found &a, const Found &b) {
+        return a.task != b.task ? a.task < b.task : a.attempt < b.attempt;
+    });
+    size_t first_new = paths_.size();
+    for (Found &f : found) {
+        if (paths_.size() == first_new || !(paths_.back() == f.path)) {
+            paths_.push_back(std::move(f.path));
+        }
+    }
+    printBusyTimes(scheduler);
 
-                    // If edge leads to anchor different from starting one, force select it.
-                    if (q_n->anchor && q_n->index != start_node.index) {
-                        anchor_edge = &e;
-                        break;
-                    }
+    std::cout << "Found " << found_num << " paths (" << scanned << " edges selected by scan)." << std::endl;
+#ifdef DEBUG
+    //filterUnique();
+    //std::cout << "Total new: " << (paths_.size() - orig_size) << std::endl;
+#endif
+}
 
-                    // Skip visited nodes.
-                    if (!visited_nodes[q_n->index]) {
-                        sum += getMetric(e, metric);
-                        appropriate_edges.push_back(&e);
-                    }
+template<Utils::Metrics M>
+bool PathManager::walkMonteCarlo(const OverlapGraph &g, const EdgeSampler &sampler,
+                                 const OverlapGraph::Node &start_node, RandomStream &gen,
+                                 VisitedSet &visited_nodes, ulong &scans, Path &p) const {
+    const OverlapGraph::Node *n = &start_node;
+    visited_nodes.insert(n->index);
+
+    // Store the starting node.
+    p.start(n);
+
+    // Defines will the path be added (considered).
+    bool acceptable = false;
+
+    // Backtrack counter.
+    int backtracks = 0;
+
+    // Construct the path.
+    while (true) {
+        // If edge leads to anchor different from starting one, force select it.
+        const OverlapGraph::Edge *edge = nullptr;
+        if (n->touches_anchor) {
+            for (ulong k : g.anchorEdges(*n)) {
+                if (g.adjacency_[k].q_index != start_node.index) {
+                    edge = &g.adjacency_[k];
+                    break;
                 }
+            }
+        }
 
-                const OverlapGraph::Edge *edge = nullptr;
-                if (anchor_edge) {  // If points to anchor, use it.
-                    edge = anchor_edge;
-                } else if (appropriate_edges.empty()) {  // No edges available (dead-end), backtrack.
-#ifdef DEBUG
-                    std::cout << "No edges available for: \t" << p << '\n';
-#endif
-                    if (backtracks < params_.backtrack_attempts && p.edges_.size() > 1) {  // Backtrack possible.
-                        bool t = false;
-                        do {
-                            p.nodes_.pop_back();
-                            p.edges_.pop_back();
-                            for (const OverlapGraph::Edge &e : p.nodes_.back()->edges) {
-                                if (!visited_nodes[e.q_index]) {
-                                    // Stop backing if you find an edge leading to unvisited node.
-                                    t = true;
-                                    break;
-                                }
-                            }
-                        } while (!p.edges_.empty() && !t);
-
-                        if (p.edges_.empty()) {
+        // Otherwise select one of the edges to unvisited nodes at random.
+        if (!edge) {
+            edge = sampler.sample(*n, visited_nodes, gen, scans);
+        }
+
+        if (!edge) {  // No edges available (dead-end), backtrack.
 #ifdef DEBUG
-                            std::cout << "Nothing to backtrack to: " << p << '\n';
+            std::cout << "No edges available for: \t" << p << '\n';
 #endif
+            if (backtracks < params_.backtrack_attempts && p.edges_.size() > 1) {  // Backtrack possible.
+                bool t = false;
+                do {
+                    p.pop();
+                    for (const OverlapGraph::Edge &e : g.edges(*p.nodes_.back())) {
+                        if (!visited_nodes[e.q_index]) {
+                            // Stop backing if you find an edge leading to unvisited node.
+                            t = true;
                             break;
                         }
-                        ++backtracks;
-
-                        n = p.nodes_.back();
-                        continue;
                     }
+                } while (!p.edges_.empty() && !t);
+
+                if (p.edges_.empty()) {
+#ifdef DEBUG
+                    std::cout << "Nothing to backtrack to: " << p << '\n';
+#endif
                     break;
-                } else { // Select one at random.
-                    // Select a random number from [0, sum]
-                    double random = dis(gen) * sum;
-
-                    // Find the selected edge.
-                    sum = 0;
-                    for (const OverlapGraph::Edge *e : appropriate_edges) {
-                        sum += getMetric(*e, metric);
-                        if (sum >= random) { // Node found.
-                            edge = e;
-                            break;
-                        }
-                    }
                 }
+                ++backtracks;
 
-                // Replace current node with next node.
-                n = &(g.nodes_[edge->q_index]);
+                n = p.nodes_.back();
+                continue;
+            }
+            break;
+        }
 
-                // Add the selected edge and next node to path.
-                p.nodes_.push_back(n);
-                p.edges_.push_back(edge);
-                visited_nodes[n->index] = true;
+        // Replace current node with next node.
+        n = &(g.nodes_[edge->q_index]);
 
-                p.updateLength();
-                if (p.length() <= 0) { // Abort when path becomes negative.
-                    break;
-                }
+        // Add the selected edge and next node to path.
+        p.push(edge, n);
+        visited_nodes.insert(n->index);
 
-                // If node is anchor, add the node and break.
-                if (n->anchor) {
-                    acceptable = true; // Accept path.
-                    break;
-                }
+        if (p.length() <= 0) { // Abort when path becomes negative.
+            break;
+        }
 
-                // Abort if length is too large.
-                if (p.length() >= params_.len_threshold) {
+        // If node is anchor, add the node and break.
+        if (n->anchor) {
+            acceptable = true; // Accept path.
+            break;
+        }
+
+        // Abort if length is too large.
+        if (p.length() >= params_.len_threshold) {
 //#ifdef DEBUG
-                    //std::cout << "Length too large (" << p.length << "): " << p << std::endl;
+            //std::cout << "Length too large (" << p.length << "): " << p << std::endl;
 //#endif
-                    break;
-                }
-            }
-
-            // Path ready to be added.
-            if (acceptable) {
-                p.updateLength();
-
-                if (p.length() < 0) {
-                    //std::cout << "Path length is negative! (" << p.length() << ")  " << p << std::endl;
-                    continue;
-                }
+            break;
+        }
+    }
 
-                paths_.push_back(p);
-                ++found;
-#ifdef DEBUG
-                std::cout << "Found path #" << paths_.size() << " of " << p.nodes_.size() << " nodes and "
-                          << p.length() << " paths: " << p << '\n';
-#endif
-            }
+    // Path ready to be added.
+    if (acceptable) {
+        if (p.length() < 0) {
+            //std::cout << "Path length is negative! (" << p.length() << ")  " << p << std::endl;
+            return false;
+        }
 #ifdef DEBUG
-            else {
-                std::cout << "No path found!\n";
-                p.updateLength();
-                std::cout << "Aborted paths' length: " << p.length() << "bp, "
-                          << p.nodes_.size() << " nodes.\n";
-            }
+        std::cout << "Found path of " << p.nodes_.size() << " nodes and "
+                  << p.length() << " paths: " << p << '\n';
 #endif
-        }
+        return true;
     }
-
-    std::cout << "Found " << found << " paths." << std::endl;
 #ifdef DEBUG
-    //filterUnique();
-    //std::cout << "Total new: " << (paths_.size() - orig_size) << std::endl;
+    std::cout << "No path found!\n";
+    std::cout << "Aborted paths' length: " << p.length() << "bp, "
+              << p.nodes_.size() << " nodes.\n";
 #endif
+    return false;
 }
 
 void PathManager::buildDeterministic(const OverlapGraph &g,
                                      const Utils::Metrics &metric) {
+    Utils::dispatchMetric(metric, [&](auto m) { buildDeterministic<decltype(m)::value>(g); });
+}
+
+template<Utils::Metrics M>
+void PathManager::buildDeterministic(const OverlapGraph &g) {
     const size_t num_nodes = g.nodes_.size();
-    ulong found = 0;
-    std::cout << "> Deterministic heuristic: " << Utils::getMetricName(metric) << std::endl;
-#ifdef DEBUG
-    int outer = 0;
-    int num_anchors = 0;
-    for (const OverlapGraph::Node &start_node : g.nodes_) {
-        if (start_node.anchor) {
-            num_anchors += 1;
-        }
-    }
-#endif
-    // For each anchor node as starting point
+    const EdgeOrder order(g, M);
+    std::cout << "> Deterministic heuristic: " << Utils::getMetricName(M) << std::endl;
+
+    // Every anchor is a task, a path from each of its edges is a step. An
+    // edge straight to another anchor gives the last path of the anchor.
+    std::vector<const OverlapGraph::Node *> anchors;
+    std::vector<uint> first_edges;
     for (const OverlapGraph::Node &start_node : g.nodes_) {
         // Skip read-nodes.
         if (!start_node.anchor) {
             continue;
         }
-#ifdef DEBUG
-        outer += 1;
-        int inner = 1;
-#endif
-        // Construct path for each node connected to start_node
-        for (const OverlapGraph::Edge &first_edge : start_node.edges) {
-#ifdef DEBUG
-            std::cout << "Build [" << outer << " / " << num_anchors << "]-["
-                      << inner << " / " << start_node.edges.size() << "]" << std::endl;
-            inner += 1;
-#endif
-            Path path;
-            // num_nodes of bools with initial value false
-            std::vector<bool> visited_nodes(num_nodes, false);
-
-            // Add first node, first edge and second node to the path
-            visited_nodes[start_node.index] = true;
-            path.nodes_.push_back(&start_node);
-            path.edges_.push_back(&first_edge);
-            // Get second node from which the path will be build
-            const OverlapGraph::Node *node = &g.nodes_[first_edge.q_index];
-
-            visited_nodes[node->index] = true;
-            path.nodes_.push_back(node);
-            // If second node was already an anchor, the path of length 2 is built
-            if (node->anchor) {
-                path.updateLength();
-                paths_.push_back(path);
-                ++found;
-                break;
-            }
-
-            // Defines will the path be added (considered).
-            bool all_ok = false;
-            int step_index = 0;
-            // Defines how many of best-scoring nodes will be ignored for path construction.
-            // 0 = use best-scoring node
-            // 1 = use second-best node
-            // ...and so on
-            // This is used to go back a step when dead end is encountered.
-            int skip_n_best = 0;
-            bool went_back = false;
-
-            // Construct the path
-            while (true) {
-                // Dead end, go back a step and try a different path
-                if (node->edges.empty()) {
-                    if (step_index == 0) {
-                        // Cannot go back a step, drop this path
-                        break;
-                    } else {
-                        // we will only go back a step once
-                        if (went_back) {
-                            break;
-                        }
-                        went_back = true;
-
-                        // Go back a step
-                        step_index -= 1;
-                        skip_n_best += 1;
-                        path.nodes_.pop_back();
-                        path.edges_.pop_back();
-                        node = path.nodes_.back();
-                        visited_nodes[node->index] = false;
-                        continue;
-                    }
-                }
-                // If we need to skip all edges, then this is a dead end, go back a step
-                if (skip_n_best >= node->edges.size() - 1) {
-                    if (step_index == 0) {
-                        // Cannot go back a step, drop this path
-                        break;
-                    }
-
-                    // we will only go back a step once
-                    if (went_back) {
-                        break;
-                    }
-                    went_back = true;
-
-                    step_index -= 1;
-                    skip_n_best += 1;
-                    path.nodes_.pop_back();
-                    path.edges_.pop_back();
-                    node = path.nodes_.back();
-                    visited_nodes[node->index] = false;
-                    continue;
-                }
-
-                // Sort (descending) edges by provided metric
-                std::vector<OverlapGraph::Edge> sorted_edges(node->edges);
-                std::stable_sort(
-                        sorted_edges.begin(),
-                        sorted_edges.end(),
-                        [&](const OverlapGraph::Edge &a, const OverlapGraph::Edge &b) -> bool {
-                            return Utils::getMetric(a, metric) > Utils::getMetric(b, metric);
-                        }
-                );
-
-                // Find edge by skipping n best
-                bool edge_found = false;
-                const OverlapGraph::Edge *edge = nullptr;
-                int this_step_skips = skip_n_best;
-                while (this_step_skips < node->edges.size() - 1) {
-                    edge = &sorted_edges[this_step_skips];
-                    // Get next node
-                    const OverlapGraph::Node *nn = &g.nodes_[edge->q_index];
-
-                    // Node was not visited yet, break the loop
-                    if (!visited_nodes[nn->index]) {
-                        edge_found = true;
-                        break;
-                    } else {
-                        // skip to next edge in this step
-                        this_step_skips += 1;
-                    }
-                }
-
-                // Yet again there are no available edges, go back a step
-                if (!edge_found) {
-                    if (step_index == 0) {
-                        // Cannot go back a step, drop this path
-                        break;
-                    }
-
-                    // we will only go back a step once
-                    if (went_back) {
-                        break;
-                    }
-                    went_back = true;
-
-                    step_index -= 1;
-                    skip_n_best += 1;
-                    path.nodes_.pop_back();
-                    path.edges_.pop_back();
-                    node = path.nodes_.back();
-                    visited_nodes[node->index] = false;
-                    continue;
-                }
-
-                // Finally, the edge was found
-                bool pushed = false;
-                for (const OverlapGraph::Edge &n_edge: node->edges) {
-                    if (n_edge.q_index == edge->q_index && n_edge.t_index == edge->t_index) {
-                        path.edges_.push_back(&n_edge);
-                        pushed = true;
-                        break;
-                    }
-                }
-
-                if (!pushed) {
-                    std::cout << "ERROR: no edge found!" << std::endl;
-                    return;
-                }
-
-                // Go to next node
-                visited_nodes[node->index] = true;
-                node = &g.nodes_[edge->q_index];
-                path.nodes_.push_back(node);
-#ifdef DEBUG
-                if (visited_nodes[node->index]) {
-                    std::cout << "WARNING: duplicate node inserted!";
-                }
-#endif
-                // If target node is anchor, add the node and break.
-                if (node->anchor) {
-                    all_ok = true;
-                    break;
-                }
-
-                step_index += 1;
-            }
-
-            if (all_ok) {
-                path.updateLength();
+        anchors.push_back(&start_node);
+        OverlapGraph::SlotRange anchor_edges = g.anchorEdges(start_node);
+        first_edges.push_back(static_cast<uint>(
+                anchor_edges.empty() ? g.edges(start_node).size()
+                                     : *anchor_edges.begin() - g.offsets_[start_node.index] + 1));
+    }
+    std::vector<std::vector<Path>> built(anchors.size());
+    for (size_t i = 0; i < anchors.size(); i++) {
+        built[i].resize(first_edges[i]);
+    }
 
-                if (path.length() < 0) { // Skip negative paths.
+    // Workers reuse their visited set between paths.
+    TaskScheduler scheduler(params_.threads);
+    std::vector<VisitedSet> visited(scheduler.threads(), VisitedSet(num_nodes));
+    scheduler.run(first_edges, [&](size_t task, uint first_edge, uint worker) {
+        const OverlapGraph::Node &start_node = *anchors[task];
 #ifdef DEBUG
-                    std::cout << "Path length is negative! (" << path.length() << ")  " << path << std::endl;
+        std::cout << "Build [n" << start_node.index << "]-["
+                  << first_edge + 1 << " / " << g.edges(start_node).size() << "]" << std::endl;
 #endif
-                    continue;
-                }
+        visited[worker].clear();
+        Path &path = built[task][first_edge];
+        if (!walkDeterministic<M>(g, order, start_node, g.edges(start_node)[first_edge], visited[worker], path)) {
+            path = Path();
+        }
+    });
 
-                paths_.push_back(path);
+    // Merge in anchor and edge order, the same for any number of threads.
+    ulong found = 0;
+    for (std::vector<Path> &anchor_paths : built) {
+        for (Path &p : anchor_paths) {
+            if (!p.nodes_.empty()) {
+                paths_.push_back(std::move(p));
                 ++found;
             }
         }
     }
+    printBusyTimes(scheduler);
+
     std::cout << "Found " << found << " paths." << std::endl;
 #ifdef DEBUG
     std::cout << "Validating paths" << std::endl;
@@ -405,8 +312,9 @@ void PathManager::buildDeterministic(const OverlapGraph &g,
 
             duplicates[p.nodes_[i]->index] = true;
 
-            if (p.nodes_[i]->index != p.edges_[j]->t_index) {
-                std::cout <<  "t_index is invalid, i=" << i << std::endl;
+            OverlapGraph::EdgeRange node_edges = g.edges(*p.nodes_[i]);
+            if (p.edges_[j] < node_edges.begin() || p.edges_[j] >= node_edges.end()) {
+                std::cout <<  "edge is not stored at its node, i=" << i << std::endl;
             }
 
             if (i + 1 < num_nodes) {
@@ -429,6 +337,152 @@ void PathManager::buildDeterministic(const OverlapGraph &g,
 #endif
 }
 
+template<Utils::Metrics M>
+bool PathManager::walkDeterministic(const OverlapGraph &g, const EdgeOrder &order,
+                                    const OverlapGraph::Node &start_node, const OverlapGraph::Edge &first_edge,
+                                    VisitedSet &visited_nodes, Path &path) const {
+    // Add first node, first edge and second node to the path
+    visited_nodes.insert(start_node.index);
+    path.start(&start_node);
+    // Get second node from which the path will be build
+    const OverlapGraph::Node *node = &g.nodes_[first_edge.q_index];
+
+    visited_nodes.insert(node->index);
+    path.push(&first_edge, node);
+    // If second node was already an anchor, the path of length 2 is built
+    if (node->anchor) {
+        return true;
+    }
+
+    // Defines will the path be added (considered).
+    bool all_ok = false;
+    int step_index = 0;
+    // Defines how many of best-scoring nodes will be ignored for path construction.
+    // 0 = use best-scoring node
+    // 1 = use second-best node
+    // ...and so on
+    // This is used to go back a step when dead end is encountered.
+    int skip_n_best = 0;
+    bool went_back = false;
+
+    // Construct the path
+    while (true) {
+        // Dead end, go back a step and try a different path
+        if (g.edges(*node).empty()) {
+            if (step_index == 0) {
+                // Cannot go back a step, drop this path
+                break;
+            } else {
+                // we will only go back a step once
+                if (went_back) {
+                    break;
+                }
+                went_back = true;
+
+                // Go back a step
+                step_index -= 1;
+                skip_n_best += 1;
+                path.pop();
+                node = path.nodes_.back();
+                visited_nodes.erase(node->index);
+                continue;
+            }
+        }
+        // If we need to skip all edges, then this is a dead end, go back a step
+        if (skip_n_best >= g.edges(*node).size() - 1) {
+            if (step_index == 0) {
+                // Cannot go back a step, drop this path
+                break;
+            }
+
+            // we will only go back a step once
+            if (went_back) {
+                break;
+            }
+            went_back = true;
+
+            step_index -= 1;
+            skip_n_best += 1;
+            path.pop();
+            node = path.nodes_.back();
+            visited_nodes.erase(node->index);
+            continue;
+        }
+
+        // Edges of the node, best first
+        OverlapGraph::EdgeRange node_edges = g.edges(*node);
+        const OverlapGraph::Edge *const *ranked_edges = order.ranked(*node);
+
+        // Find edge by skipping n best
+        bool edge_found = false;
+        const OverlapGraph::Edge *edge = nullptr;
+        int this_step_skips = skip_n_best;
+        while (this_step_skips < node_edges.size() - 1) {
+            edge = ranked_edges[this_step_skips];
+            // Get next node
+            const OverlapGraph::Node *nn = &g.nodes_[edge->q_index];
+
+            // Node was not visited yet, break the loop
+            if (!visited_nodes[nn->index]) {
+                edge_found = true;
+                break;
+            } else {
+                // skip to next edge in this step
+                this_step_skips += 1;
+            }
+        }
+
+        // Yet again there are no available edges, go back a step
+        if (!edge_found) {
+            if (step_index == 0) {
+                // Cannot go back a step, drop this path
+                break;
+            }
+
+            // we will only go back a step once
+            if (went_back) {
+                break;
+            }
+            went_back = true;
+
+            step_index -= 1;
+            skip_n_best += 1;
+            path.pop();
+            node = path.nodes_.back();
+            visited_nodes.erase(node->index);
+            continue;
+        }
+
+        // Finally, the edge was found, go to next node
+        visited_nodes.insert(node->index);
+        node = &g.nodes_[edge->q_index];
+        path.push(edge, node);
+#ifdef DEBUG
+        if (visited_nodes[node->index]) {
+            std::cout << "WARNING: duplicate node inserted!";
+        }
+#endif
+        // If target node is anchor, add the node and break.
+        if (node->anchor) {
+            all_ok = true;
+            break;
+        }
+
+        step_index += 1;
+    }
+
+    if (all_ok) {
+        if (path.length() < 0) { // Skip negative paths.
+#ifdef DEBUG
+            std::cout << "Path length is negative! (" << path.length() << ")  " << path << std::endl;
+#endif
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
 void PathManager::filterUnique() {
     // Use equality operator to identify unique paths.
     auto last = std::unique(paths_.begin(), paths_.end());
@@ -55,14 +55,14 @@ bool Scaffolder::write(const char *filename) {
         std::cerr << "Scaffold is empty!" << std::endl;
         return false;
     } else if (p_.nodes_.size() == 1) { // Single node path.
-        std::cout << p_.nodes_[0]->name << std::endl;
-        filestream << reverse(std::move(getSequenceFrom(p_.nodes_[0]->name)));
+        std::cout << g_.name(*p_.nodes_[0]) << std::endl;
+        filestream << reverse(std::move(getSequenceFrom(g_.name(*p_.nodes_[0]))));
         return true;
     }
 
     // First sequence.
-    std::cout << p_.nodes_[0]->name;
-    tmp = getSequenceFrom(p_.nodes_[0]->name);
+    std::cout << g_.name(*p_.nodes_[0]);
+    tmp = getSequenceFrom(g_.name(*p_.nodes_[0]));
     sequence += reverse(substring(tmp, p_.edges_[0]->t_end + 1, tmp.size()));
 
     // Intermediate sequences.
@@ -74,11 +74,11 @@ bool Scaffolder::write(const char *filename) {
         ulong end = e->q_end;
 
         if (start < end) {
-            tmp = getSequenceFrom(p_.nodes_[i]->name);
-            if (e->relative_strand) {
+            tmp = getSequenceFrom(g_.name(*p_.nodes_[i]));
+            if (e->relativeStrand()) {
                 swapBases(tmp);
             }
-            std::cout << '-' << p_.nodes_[i]->name;
+            std::cout << '-' << g_.name(*p_.nodes_[i]);
             sequence += reverse(substring(tmp, start + 1, end));
             // The +1 is to not include the overlap area (next one will do that)
 
@@ -91,8 +91,8 @@ bool Scaffolder::write(const char *filename) {
     }
 
     // Last sequence.
-    std::cout << '-' << p_.nodes_[p_.nodes_.size() - 1]->name << std::endl;
-    tmp = getSequenceFrom(p_.nodes_[p_.nodes_.size() - 1]->name);
+    std::cout << '-' << g_.name(*p_.nodes_[p_.nodes_.size() - 1]) << std::endl;
+    tmp = getSequenceFrom(g_.name(*p_.nodes_[p_.nodes_.size() - 1]));
     sequence += reverse(substring(tmp, 0, p_.edges_[p_.edges_.size() - 1]->q_end));
 
     std::reverse(sequence.begin(), sequence.end());
@@ -101,7 +101,7 @@ bool Scaffolder::write(const char *filename) {
     return true;
 }
 
-std::string &Scaffolder::getSequenceFrom(const std::string &name) {
+std::string &Scaffolder::getSequenceFrom(std::string_view name) {
     ulong index;
     for (index = 0; index < names_.size(); index++) {
         if (name == names_[index]) {
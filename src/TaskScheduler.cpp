@@ -0,0 +1,112 @@
+#include <TaskScheduler.hpp>
+
+#include <algorithm>
+#include <thread>
+
+#include <Stopwatch.hpp>
+
+TaskScheduler::TaskScheduler(uint threads) : threads_(std::max(1u, threads)) {}
+
+void TaskScheduler::run(const std::vector<uint> &steps, const Step &step) {
+    // Tasks with more steps than a range can hold are split into parts
+    // that are taken one after another.
+    std::vector<Part> parts;
+    for (size_t task = 0; task < steps.size(); task++) {
+        for (uint first = 0; first < steps[task]; first += std::min(steps[task] - first, MAX_STEPS)) {
+            parts.push_back({task, first});
+        }
+    }
+
+    std::vector<Slot> slots(threads_);
+    std::vector<ulong> steals(threads_, 0);
+    busy_.assign(threads_, 0.0);
+    std::atomic<size_t> next{0};
+
+    auto work = [&](uint worker) {
+        Slot &slot = slots[worker];
+        Stopwatch timer;
+        timer.start();
+        double busy = 0; // Kept locally, neighbouring workers write busy_ too.
+        while (true) {
+            uint s;
+            if (claim(slot, s)) {
+                timer.lap();
+                const Part &part = parts[slot.task.load(std::memory_order_relaxed)];
+                step(part.task, part.first + s, worker);
+                busy += timer.lap();
+                continue;
+            }
+
+            // Own range is done, take the next part or help the slowest worker.
+            size_t p = next++;
+            if (p < parts.size()) {
+                slot.task.store(p, std::memory_order_relaxed);
+                uint64_t range = slot.range.load(std::memory_order_relaxed);
+                uint size = std::min(steps[parts[p].task] - parts[p].first, MAX_STEPS);
+                slot.range.store(pack(0, size, tag(range) + 1), std::memory_order_release);
+            } else if (steal(slots, worker)) {
+                ++steals[worker];
+            } else {
+                break;
+            }
+        }
+        busy_[worker] = busy;
+    };
+
+    std::vector<std::thread> workers;
+    for (uint w = 1; w < threads_; w++) {
+        workers.emplace_back(work, w);
+    }
+    work(0);
+    for (std::thread &w : workers) {
+        w.join();
+    }
+
+    steals_ = 0;
+    for (ulong s : steals) {
+        steals_ += s;
+    }
+}
+
+bool TaskScheduler::claim(Slot &slot, uint &step) {
+    uint64_t range = slot.range.load(std::memory_order_acquire);
+    while (first(range) < end(range)) {
+        if (slot.range.compare_exchange_weak(range, pack(first(range) + 1, end(range), tag(range)),
+                                             std::memory_order_acquire)) {
+            step = first(range);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::steal(std::vector<Slot> &slots, uint thief) {
+    while (true) {
+        // Victim with most steps left.
+        uint victim = thief;
+        uint64_t range = 0;
+        for (uint w = 0; w < slots.size(); w++) {
+            uint64_t r = slots[w].range.load(std::memory_order_acquire);
+            if (w != thief && end(r) - first(r) > end(range) - first(range)) {
+                victim = w;
+                range = r;
+            }
+        }
+        if (victim == thief) {
+            return false;
+        }
+
+        // The task is read before the range is taken. The victim only
+        // changes it once its range is empty, which fails the swap below.
+        size_t task = slots[victim].task.load(std::memory_order_relaxed);
+        uint mid = first(range) + (end(range) - first(range)) / 2;
+        if (slots[victim].range.compare_exchange_strong(range, pack(first(range), mid, tag(range)),
+                                                        std::memory_order_acq_rel)) {
+            Slot &own = slots[thief];
+            own.task.store(task, std::memory_order_relaxed);
+            uint64_t own_range = own.range.load(std::memory_order_relaxed);
+            own.range.store(pack(mid, end(range), tag(own_range) + 1), std::memory_order_release);
+            return true;
+        }
+    }
+}
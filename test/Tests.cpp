@@ -1,8 +1,1277 @@
 #include "catch.hpp"
 
-#include "OverlapGraph.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "EdgeOrder.hpp"
+#include "EdgeSampler.hpp"
+#include "GraphCache.hpp"
+#include "MappedFile.hpp"
+#include "NameInterner.hpp"
+#include "OverlapBatch.hpp"
+#include "OverlapGraph.hpp"
+#include "PAFTags.hpp"
+#include "PAFTokenizer.hpp"
+#include "PathManager.hpp"
+#include "Stopwatch.hpp"
+#include "TaskScheduler.hpp"
+#include "VisitedSet.hpp"
+#include "Utils.hpp"
+
+static char PAF_FILE[] = "test/res/EColi_CR_overlaps.paf";
+
+static void setDefaultFilter(OverlapGraph &g) {
+    g.filter_params_ = {OverlapGraph::AVG, 0, 0.0f, ULONG_MAX, 1.0f};
+}
+
+static void requireSameGraph(const OverlapGraph &a, const OverlapGraph &b) {
+    REQUIRE(a.nodes_.size() == b.nodes_.size());
+    REQUIRE(a.edgesNum() == b.edgesNum());
+    REQUIRE(a.offsets_ == b.offsets_);
+    for (size_t i = 0; i < a.nodes_.size(); i++) {
+        const OverlapGraph::Node &n = a.nodes_[i], &m = b.nodes_[i];
+        REQUIRE(a.name(n) == b.name(m));
+        REQUIRE(n.anchor == m.anchor);
+        REQUIRE(n.length == m.length);
+        REQUIRE(n.touches_anchor == m.touches_anchor);
+        REQUIRE(std::equal(a.anchorEdges(n).begin(), a.anchorEdges(n).end(),
+                           b.anchorEdges(m).begin(), b.anchorEdges(m).end()));
+    }
+    for (size_t i = 0; i < a.adjacency_.size(); i++) {
+        const OverlapGraph::Edge &e = a.adjacency_[i], &f = b.adjacency_[i];
+        REQUIRE(e.q_index == f.q_index);
+        REQUIRE(e.q_start == f.q_start);
+        REQUIRE(e.t_end == f.t_end);
+        REQUIRE(e.overlap_score == f.overlap_score);
+        REQUIRE(e.extension_score == f.extension_score);
+        REQUIRE(e.sequenceIdentity() == f.sequenceIdentity());
+        REQUIRE(e.relativeStrand() == f.relativeStrand());
+    }
+}
+
+TEST_CASE("Name interning") {
+    NameInterner names;
+    bool inserted;
+    for (int i = 0; i < 1000; i++) {
+        REQUIRE(names.intern("read" + std::to_string(i), inserted) == static_cast<uint>(i));
+        REQUIRE(inserted);
+    }
+    REQUIRE(names.intern("read17", inserted) == 17);
+    REQUIRE_FALSE(inserted);
+    REQUIRE(names.find("read999") == 999);
+    REQUIRE(names.find("read1000") == NameInterner::NOT_FOUND);
+    REQUIRE(names.name(names.offset(42)) == "read42");
+    REQUIRE(names.size() == 1000);
+}
 
 TEST_CASE("Graph loading") {
-    // TODO: write a test (or more) for graph construction!
-    REQUIRE(1 == 1);
+    OverlapGraph stream, mapped;
+    setDefaultFilter(stream);
+    setDefaultFilter(mapped);
+    stream.loader_mode_ = OverlapGraph::ISTREAM;
+    mapped.loader_mode_ = OverlapGraph::MMAP;
+
+    REQUIRE(stream.load(PAF_FILE, true));
+    REQUIRE(mapped.load(PAF_FILE, true));
+    REQUIRE(stream.edgesNum() > 0);
+    requireSameGraph(stream, mapped);
+}
+
+TEST_CASE("Parallel graph loading") {
+    OverlapGraph sequential, parallel;
+    setDefaultFilter(sequential);
+    setDefaultFilter(parallel);
+    parallel.load_threads_ = 7;
+
+    REQUIRE(sequential.load(PAF_FILE, true));
+    REQUIRE(parallel.load(PAF_FILE, true));
+    requireSameGraph(sequential, parallel);
+}
+
+TEST_CASE("Oversized coordinates") {
+    char path[] = "/tmp/telomeri_int_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    // The largest int is a valid coordinate, anything above makes the line malformed.
+    for (const char *len : {"2147483647", "2147483648", "99999999999999999999"}) {
+        {
+            std::ofstream out(path);
+            out << "read1\t1000\t0\t800\t+\tread2\t1000\t200\t1000\t800\t800\t0\n"
+                << "read2\t" << len << "\t0\t800\t+\tread3\t1000\t200\t1000\t800\t800\t0\n";
+        }
+        for (uint threads : {1u, 2u}) {
+            OverlapGraph g;
+            setDefaultFilter(g);
+            g.load_threads_ = threads;
+            REQUIRE(g.load(path, false) == (std::strcmp(len, "2147483647") == 0));
+        }
+    }
+    std::remove(path);
+}
+
+TEST_CASE("Compact edges") {
+    REQUIRE(sizeof(OverlapGraph::Edge) <= 32);
+    for (float si : {0.0f, 0.002f, 0.5f, 0.87654f, 1.0f}) {
+        for (bool strand : {false, true}) {
+            OverlapGraph::Edge e(1, 3, 4, 5, 6, 7.5f, si, 8.5f, strand);
+            REQUIRE(std::abs(e.sequenceIdentity() - si) <= 0.5f / 32767);
+            REQUIRE(e.relativeStrand() == strand);
+            REQUIRE(e.reversed(2).q_index == 2);
+            REQUIRE(e.reversed(2).relativeStrand() == strand);
+            REQUIRE(e.reversed(2).sequenceIdentity() == e.sequenceIdentity());
+        }
+    }
+
+    // Every edge is stored once per node, the copy at the other node leads back.
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(PAF_FILE, true));
+    REQUIRE(g.bytesPerEdge() == 2 * sizeof(OverlapGraph::Edge));
+    for (const OverlapGraph::Node &n : g.nodes_) {
+        for (const OverlapGraph::Edge &e : g.edges(n)) {
+            OverlapGraph::EdgeRange back = g.edges(g.nodes_[e.q_index]);
+            REQUIRE(std::any_of(back.begin(), back.end(), [&](const OverlapGraph::Edge &f) {
+                return f.q_index == n.index && f.q_start == e.t_start && f.t_end == e.q_end;
+            }));
+        }
+    }
+}
+
+TEST_CASE("Early rejects") {
+    // Every line fails the length check, so none reaches name lookup.
+    for (uint threads : {1u, 3u}) {
+        OverlapGraph g;
+        setDefaultFilter(g);
+        g.filter_params_.min_overlap_length = ULONG_MAX;
+        g.load_threads_ = threads;
+        REQUIRE(g.load(PAF_FILE, true));
+        REQUIRE(g.nodes_.empty());
+        REQUIRE(g.names_.size() == 0);
+        REQUIRE(g.loadStats().earlyRejects() == 24127);
+    }
+
+    OverlapGraph sequential, parallel;
+    setDefaultFilter(sequential);
+    setDefaultFilter(parallel);
+    sequential.filter_params_.min_overlap_length = 5000;
+    parallel.filter_params_.min_overlap_length = 5000;
+    parallel.load_threads_ = 3;
+    REQUIRE(sequential.load(PAF_FILE, true));
+    REQUIRE(parallel.load(PAF_FILE, true));
+    LoadStats s = sequential.loadStats(), p = parallel.loadStats();
+    REQUIRE(s.overlap_length_rejects > 0);
+    REQUIRE(s.earlyRejects() == p.earlyRejects());
+    REQUIRE(s.self_rejects == p.self_rejects);
+    REQUIRE(s.lines == 24127);
+    REQUIRE(s.earlyRejects() + s.self_rejects + s.edges == s.lines);
+    REQUIRE(s.name_lookups == 2 * s.edges);
+    REQUIRE(s.name_hits == s.name_lookups - sequential.nodes_.size());
+}
+
+TEST_CASE("Graph loading from a pipe") {
+    char dir[] = "/tmp/telomeri_fifo_XXXXXX";
+    REQUIRE(mkdtemp(dir));
+    std::string fifo = std::string(dir) + "/overlaps.paf";
+    REQUIRE(mkfifo(fifo.c_str(), 0600) == 0);
+
+    // Feed the file in small writes that split lines.
+    std::thread writer([&fifo] {
+        MappedFile file(PAF_FILE);
+        std::ofstream out(fifo, std::ios::binary);
+        for (size_t pos = 0; pos < file.size(); pos += 1000) {
+            out.write(file.data() + pos, std::min<size_t>(1000, file.size() - pos));
+            out.flush();
+        }
+    });
+
+    OverlapGraph mapped, piped;
+    setDefaultFilter(mapped);
+    setDefaultFilter(piped);
+    REQUIRE(mapped.load(PAF_FILE, true));
+    REQUIRE(piped.load(&fifo[0], true));
+    writer.join();
+    std::remove(fifo.c_str());
+    rmdir(dir);
+
+    requireSameGraph(mapped, piped);
+}
+
+/** Writes data as BGZF: independent gzip members of at most 64000 bytes
+ * with the block size in the 'BC' extra field, followed by the empty block. */
+static void writeBgzf(const char *path, const char *data, size_t n) {
+    std::ofstream out(path, std::ios::binary);
+    for (size_t pos = 0; pos <= n; pos += 64000) {
+        size_t len = std::min<size_t>(64000, n - pos);
+        std::vector<Bytef> cdata(compressBound(len) + 16);
+        z_stream z{};
+        REQUIRE(deflateInit2(&z, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+        z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + pos));
+        z.avail_in = static_cast<uInt>(len);
+        z.next_out = cdata.data();
+        z.avail_out = static_cast<uInt>(cdata.size());
+        REQUIRE(deflate(&z, Z_FINISH) == Z_STREAM_END);
+        size_t clen = z.total_out;
+        deflateEnd(&z);
+
+        uint32_t crc = crc32(0, reinterpret_cast<const Bytef *>(data + pos), static_cast<uInt>(len));
+        size_t bsize = 18 + clen + 8 - 1;
+        unsigned char header[18] = {0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0,
+                                    static_cast<unsigned char>(bsize), static_cast<unsigned char>(bsize >> 8)};
+        unsigned char trailer[8];
+        for (int i = 0; i < 4; i++) {
+            trailer[i] = static_cast<unsigned char>(crc >> (8 * i));
+            trailer[4 + i] = static_cast<unsigned char>(len >> (8 * i));
+        }
+        out.write(reinterpret_cast<char *>(header), sizeof(header));
+        out.write(reinterpret_cast<char *>(cdata.data()), clen);
+        out.write(reinterpret_cast<char *>(trailer), sizeof(trailer));
+        if (len == 0) {
+            break;
+        }
+    }
+}
+
+TEST_CASE("Compressed graph loading") {
+    MappedFile file(PAF_FILE);
+    REQUIRE(file.valid());
+    OverlapGraph mapped;
+    setDefaultFilter(mapped);
+    REQUIRE(mapped.load(PAF_FILE, true));
+
+    // Gzip file of two members, split in the middle of a line.
+    char dir[] = "/tmp/telomeri_gz_XXXXXX";
+    REQUIRE(mkdtemp(dir));
+    std::string gz_path = std::string(dir) + "/overlaps.paf.gz";
+    for (size_t split : {file.size() / 3, file.size()}) {
+        gzFile gz = gzopen(gz_path.c_str(), "wb");
+        REQUIRE(gz);
+        REQUIRE(gzwrite(gz, file.data(), static_cast<unsigned>(split)) == static_cast<int>(split));
+        gzclose(gz);
+        if (split < file.size()) {
+            gz = gzopen((gz_path + ".2").c_str(), "wb");
+            REQUIRE(gzwrite(gz, file.data() + split, static_cast<unsigned>(file.size() - split)) > 0);
+            gzclose(gz);
+            std::ofstream out(gz_path, std::ios::binary | std::ios::app);
+            out << std::ifstream(gz_path + ".2", std::ios::binary).rdbuf();
+            std::remove((gz_path + ".2").c_str());
+        }
+
+        OverlapGraph g;
+        setDefaultFilter(g);
+        REQUIRE(g.load(&gz_path[0], true));
+        REQUIRE(g.loadStats().bytes == file.size());
+        requireSameGraph(mapped, g);
+    }
+
+    // BGZF, decompressed by several threads.
+    std::string bgzf_path = std::string(dir) + "/overlaps.paf.bgz";
+    writeBgzf(bgzf_path.c_str(), file.data(), file.size());
+    for (uint threads : {1u, 3u}) {
+        OverlapGraph g;
+        setDefaultFilter(g);
+        g.load_threads_ = threads;
+        REQUIRE(g.load(&bgzf_path[0], true));
+        requireSameGraph(mapped, g);
+    }
+
+    // Empty BGZF file is only the end of file block, alone or as a shard.
+    std::string empty_path = std::string(dir) + "/empty.paf.bgz";
+    writeBgzf(empty_path.c_str(), "", 0);
+    for (uint threads : {1u, 3u}) {
+        OverlapGraph empty;
+        setDefaultFilter(empty);
+        empty.load_threads_ = threads;
+        REQUIRE(empty.load(&empty_path[0], true));
+        REQUIRE(empty.edgesNum() == 0);
+
+        OverlapGraph sharded;
+        setDefaultFilter(sharded);
+        sharded.load_threads_ = threads;
+        REQUIRE(sharded.load({PAF_FILE, empty_path}, true));
+        requireSameGraph(mapped, sharded);
+    }
+    std::remove(empty_path.c_str());
+
+    // Decompressed size in a block trailer above the 64 KiB BGZF limit.
+    std::string huge_path = std::string(dir) + "/huge.paf.bgz";
+    {
+        MappedFile bgzf(bgzf_path.c_str());
+        std::string data(bgzf.data(), bgzf.size());
+        size_t block_size = static_cast<unsigned char>(data[16]) + (static_cast<unsigned char>(data[17]) << 8) + 1;
+        std::memset(&data[block_size - 4], 0xff, 4);
+        std::ofstream(huge_path, std::ios::binary).write(data.data(), data.size());
+    }
+    OverlapGraph huge;
+    setDefaultFilter(huge);
+    REQUIRE_FALSE(huge.load(&huge_path[0], true));
+    std::remove(huge_path.c_str());
+
+    // Truncated input is an error, not a shorter graph.
+    for (const std::string &path : {gz_path, bgzf_path}) {
+        REQUIRE(truncate(path.c_str(), MappedFile(path.c_str()).size() / 2) == 0);
+        OverlapGraph g;
+        setDefaultFilter(g);
+        REQUIRE_FALSE(g.load(const_cast<char *>(path.c_str()), true));
+        std::remove(path.c_str());
+    }
+    rmdir(dir);
+}
+
+TEST_CASE("PAF optional tags") {
+    PAFTags tags("tp:A:P\tcm:i:12\ts1:i:40\tdv:f:0.0125");
+    int cm, s1;
+    float dv;
+    REQUIRE(tags.type() == 'P');
+    REQUIRE_FALSE(tags.secondary());
+    REQUIRE(tags.minimizers(cm));
+    REQUIRE(cm == 12);
+    REQUIRE(tags.chainScore(s1));
+    REQUIRE(s1 == 40);
+    REQUIRE(tags.divergence(dv));
+    REQUIRE(dv == 0.0125f);
+    REQUIRE_FALSE(tags.getInt("dv", cm));
+    REQUIRE_FALSE(tags.getInt("rl", cm));
+    REQUIRE(PAFTags().type() == '\0');
+
+    // Records with no, fewer and more tags than minimap2 usually writes.
+    char path[] = "/tmp/telomeri_tags_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+    {
+        std::ofstream out(path);
+        out << "read1\t1000\t0\t800\t+\tread2\t1000\t200\t1000\t800\t800\t0\n"
+            << "read2\t1000\t0\t800\t+\tread3\t1000\t200\t1000\t800\t800\t0\ttp:A:P\tcm:i:5\n"
+            << "read3\t1000\t0\t800\t+\tread4\t1000\t200\t1000\t800\t800\t0\ttp:A:S\tcm:i:5\t"
+            << "s1:i:700\tdv:f:0.01\trl:i:0\n"
+            << "read4\t1000\t0\t800\t-\tread5\t1000\t200\t1000\t800\t800\t0\ttp:A:P\n";
+    }
+
+    for (bool skip_secondary : {false, true}) {
+        OverlapGraph stream, mapped;
+        setDefaultFilter(stream);
+        setDefaultFilter(mapped);
+        stream.filter_params_.skip_secondary = skip_secondary;
+        mapped.filter_params_.skip_secondary = skip_secondary;
+        stream.loader_mode_ = OverlapGraph::ISTREAM;
+        REQUIRE(stream.load(path, false));
+        REQUIRE(mapped.load(path, false));
+        REQUIRE(mapped.edgesNum() == (skip_secondary ? 3 : 4));
+        requireSameGraph(stream, mapped);
+    }
+    std::remove(path);
+
+    // All records of the bundled file are secondary.
+    OverlapGraph g;
+    setDefaultFilter(g);
+    g.filter_params_.skip_secondary = true;
+    REQUIRE(g.load(PAF_FILE, true));
+    REQUIRE(g.edgesNum() == 0);
+}
+
+TEST_CASE("Batch filtering") {
+    // Small coordinates produce zero lengths, so ratios include inf and NaN.
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> coordinate(0, 12);
+    OverlapBatch batch;
+    while (!batch.full()) {
+        OverlapGraph::PAFOverlap o{};
+        o.query_start = coordinate(rng);
+        o.query_end = o.query_start + coordinate(rng);
+        o.query_len = o.query_end + coordinate(rng);
+        o.target_start = coordinate(rng);
+        o.target_end = o.target_start + coordinate(rng);
+        o.target_len = o.target_end + coordinate(rng);
+        batch.push(o);
+    }
+
+    const OverlapGraph::FilterParameters params[] = {
+            {OverlapGraph::AVG, 0, 0.0f, ULONG_MAX, 1.0f},
+            {OverlapGraph::AVG, 5, 0.3f, 6, 0.7f},
+            {OverlapGraph::MIN, 3, 0.5f, 4, 0.5f},
+            {OverlapGraph::MAX, 7, 0.1f, 9, 1.5f},
+            {OverlapGraph::SUM, 9, 0.25f, 11, 0.33f},
+    };
+    for (const OverlapGraph::FilterParameters &p : params) {
+        OverlapGraph g;
+        g.filter_params_ = p;
+        size_t passed = batch.evaluate(g, OverlapBatch::SCALAR);
+        std::vector<size_t> expected_rejects;
+        for (int r = OverlapGraph::SHORT_OVERLAP; r <= OverlapGraph::HIGH_OVERHANG_PERCENTAGE; r++) {
+            expected_rejects.push_back(batch.rejected(static_cast<OverlapGraph::FilterResult>(r)));
+        }
+        std::vector<bool> expected;
+        for (size_t i = 0; i < batch.size(); i++) {
+            expected.push_back(batch.passed(i));
+        }
+        REQUIRE(passed > 0);
+        REQUIRE(passed < batch.size());
+
+        for (OverlapBatch::Kernel kernel : {OverlapBatch::SSE2, OverlapBatch::AVX2}) {
+            if (OverlapBatch::supported(kernel)) {
+                REQUIRE(batch.evaluate(g, kernel) == passed);
+                for (int r = OverlapGraph::SHORT_OVERLAP; r <= OverlapGraph::HIGH_OVERHANG_PERCENTAGE; r++) {
+                    REQUIRE(batch.rejected(static_cast<OverlapGraph::FilterResult>(r)) == expected_rejects[r - 1]);
+                }
+                for (size_t i = 0; i < batch.size(); i++) {
+                    REQUIRE(batch.passed(i) == expected[i]);
+                }
+            }
+        }
+    }
+
+    // Loading with the record-at-a-time iostream filter gives the same graph.
+    for (const OverlapGraph::FilterParameters &p : params) {
+        OverlapGraph stream, mapped;
+        stream.filter_params_ = p;
+        mapped.filter_params_ = p;
+        stream.filter_params_.min_overlap_length *= 300;
+        mapped.filter_params_.min_overlap_length *= 300;
+        stream.loader_mode_ = OverlapGraph::ISTREAM;
+        REQUIRE(stream.load(PAF_FILE, true));
+        REQUIRE(mapped.load(PAF_FILE, true));
+        LoadStats s = stream.loadStats(), m = mapped.loadStats();
+        REQUIRE(s.overlap_length_rejects == m.overlap_length_rejects);
+        REQUIRE(s.overlap_percentage_rejects == m.overlap_percentage_rejects);
+        REQUIRE(s.overhang_length_rejects == m.overhang_length_rejects);
+        REQUIRE(s.overhang_percentage_rejects == m.overhang_percentage_rejects);
+        REQUIRE(s.self_rejects == m.self_rejects);
+        requireSameGraph(stream, mapped);
+    }
+}
+
+TEST_CASE("PAF tokenizer") {
+    MappedFile file(PAF_FILE);
+    REQUIRE(file.valid());
+    std::vector<uint32_t> expected, found(file.size());
+    for (size_t i = 0; i < file.size(); i++) {
+        if (file.data()[i] == '\t' || file.data()[i] == '\n') {
+            expected.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    for (PAFTokenizer::Kernel kernel : {PAFTokenizer::SCALAR, PAFTokenizer::SSE2, PAFTokenizer::AVX2}) {
+        if (!PAFTokenizer::supported(kernel)) {
+            continue;
+        }
+        size_t n = PAFTokenizer::scan(file.data(), file.size(), found.data(), kernel);
+        REQUIRE(std::vector<uint32_t>(found.begin(), found.begin() + n) == expected);
+
+        // Unaligned starts and lengths that end inside a vector step.
+        for (size_t offset = 0; offset < 40; offset += 7) {
+            for (size_t len = 0; len < 100; len += 3) {
+                size_t m = PAFTokenizer::scan(file.data() + offset, len, found.data(), kernel);
+                size_t k = 0;
+                for (size_t i = 0; i < len; i++) {
+                    char c = file.data()[offset + i];
+                    if (c == '\t' || c == '\n') {
+                        REQUIRE(found[k++] == i);
+                    }
+                }
+                REQUIRE(m == k);
+            }
+        }
+    }
+}
+
+TEST_CASE("Graph cache") {
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(PAF_FILE, true));
+
+    char path[] = "/tmp/telomeri_cache_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+    REQUIRE(GraphCache::write(g, path, 42));
+
+    OverlapGraph cached;
+    setDefaultFilter(cached);
+    REQUIRE(GraphCache::read(cached, path, 42));
+    requireSameGraph(g, cached);
+    REQUIRE(cached.names_.find(g.name(g.nodes_.back())) == g.nodes_.size() - 1);
+
+    // Stale inputs or different filter parameters invalidate the cache.
+    OverlapGraph stale;
+    setDefaultFilter(stale);
+    REQUIRE_FALSE(GraphCache::read(stale, path, 43));
+    stale.filter_params_.min_overlap_length = 1000;
+    REQUIRE_FALSE(GraphCache::read(stale, path, 42));
+    setDefaultFilter(stale);
+    stale.filter_params_.skip_secondary = true;
+    REQUIRE_FALSE(GraphCache::read(stale, path, 42));
+    std::remove(path);
+}
+
+TEST_CASE("Corrupted graph cache") {
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(PAF_FILE, true));
+
+    char path[] = "/tmp/telomeri_cache_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+    REQUIRE(GraphCache::write(g, path, 42));
+    std::string cache;
+    {
+        MappedFile file(path);
+        cache.assign(file.data(), file.size());
+    }
+
+    // Name sections are the last ones: arena, name offsets and hash slots.
+    // Locate the offsets by their contents, the arena ends before them.
+    uint64_t n = g.nodes_.size();
+    std::string name_offsets(reinterpret_cast<const char *>(&n), sizeof(n));
+    for (uint i = 0; i < n; i++) {
+        uint64_t offset = g.names_.offset(i);
+        name_offsets.append(reinterpret_cast<const char *>(&offset), sizeof(offset));
+    }
+    size_t offsets_pos = cache.find(name_offsets);
+    REQUIRE(offsets_pos != std::string::npos);
+    size_t slots_pos = offsets_pos + sizeof(n) + n * sizeof(uint64_t);
+    uint64_t slot_num;
+    std::memcpy(&slot_num, &cache[slots_pos], sizeof(slot_num));
+    REQUIRE(cache.size() == slots_pos + sizeof(slot_num) + slot_num * 2 * sizeof(uint));
+    uint arena_size = static_cast<uint>(g.names_.offset(n - 1) + sizeof(uint) + g.name(g.nodes_.back()).size());
+    REQUIRE(g.names_.arenaSize() == arena_size);
+
+    // Returns the slot ids, each after its hash.
+    auto slotIds = [&](std::string &c) {
+        std::vector<char *> ids;
+        for (uint64_t i = 0; i < slot_num; i++) {
+            ids.push_back(&c[slots_pos + sizeof(slot_num) + i * 2 * sizeof(uint) + sizeof(uint)]);
+        }
+        return ids;
+    };
+    auto readCorrupted = [&](const std::function<void(std::string &)> &corrupt) {
+        std::string c = cache;
+        corrupt(c);
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(c.data(), c.size());
+        OverlapGraph cached;
+        setDefaultFilter(cached);
+        return GraphCache::read(cached, path, 42);
+    };
+    auto put = [](char *p, uint v) { std::memcpy(p, &v, sizeof(v)); };
+    auto get = [](const char *p) { uint v; std::memcpy(&v, p, sizeof(v)); return v; };
+    const uint empty = NameInterner::NOT_FOUND;
+
+    REQUIRE(readCorrupted([](std::string &) {}));
+    // Length prefix of the name runs past the arena.
+    REQUIRE_FALSE(readCorrupted([&](std::string &c) {
+        uint64_t offset = arena_size - 2;
+        std::memcpy(&c[offsets_pos + sizeof(n) + (n - 1) * sizeof(offset)], &offset, sizeof(offset));
+    }));
+    // Characters of the name run past the arena.
+    REQUIRE_FALSE(readCorrupted([&](std::string &c) {
+        put(&c[offsets_pos - (8 - arena_size % 8) % 8 - arena_size + g.names_.offset(n - 1)], arena_size);
+    }));
+    // Slot id that is not a node.
+    REQUIRE_FALSE(readCorrupted([&](std::string &c) {
+        for (char *id : slotIds(c)) {
+            if (get(id) == empty) {
+                put(id, static_cast<uint>(n));
+                break;
+            }
+        }
+    }));
+    // No empty slot, so probing never ends.
+    REQUIRE_FALSE(readCorrupted([&](std::string &c) {
+        for (char *id : slotIds(c)) {
+            if (get(id) == empty) {
+                put(id, 0);
+            }
+        }
+    }));
+    // Table size that is not a power of two.
+    REQUIRE_FALSE(readCorrupted([&](std::string &c) {
+        uint64_t fewer = slot_num - 1;
+        std::memcpy(&c[slots_pos], &fewer, sizeof(fewer));
+    }));
+    std::remove(path);
+}
+
+TEST_CASE("Incremental graph ingest") {
+    // Overlap file split in two at a line boundary.
+    MappedFile file(PAF_FILE);
+    REQUIRE(file.valid());
+    const char *split = static_cast<const char *>(std::memchr(file.data() + file.size() / 2, '\n', file.size() / 2));
+    REQUIRE(split);
+    size_t first_size = split + 1 - file.data();
+
+    char dir[] = "/tmp/telomeri_append_XXXXXX";
+    REQUIRE(mkdtemp(dir));
+    std::string first = std::string(dir) + "/first.paf", second = std::string(dir) + "/second.paf";
+    std::string snapshot = std::string(dir) + "/first.tgraph";
+    std::ofstream(first, std::ios::binary).write(file.data(), first_size);
+    std::ofstream(second, std::ios::binary).write(file.data() + first_size, file.size() - first_size);
+
+    OverlapGraph full;
+    setDefaultFilter(full);
+    full.filter_params_.min_overlap_length = 500;
+    REQUIRE(full.load(&first[0], false));
+    REQUIRE(full.load(&second[0], true));
+    REQUIRE(full.bytesPerEdge() == 2 * sizeof(OverlapGraph::Edge)); // Grown to the exact size.
+
+    OverlapGraph base;
+    setDefaultFilter(base);
+    base.filter_params_.min_overlap_length = 500;
+    REQUIRE(base.load(&first[0], false));
+    ulong fingerprint;
+    REQUIRE(GraphCache::fingerprint({first.c_str()}, fingerprint));
+    REQUIRE(GraphCache::write(base, snapshot.c_str(), fingerprint));
+
+    // Filter parameters come from the snapshot, only the new file is parsed.
+    OverlapGraph appended;
+    ulong stored;
+    REQUIRE(GraphCache::readSnapshot(appended, snapshot.c_str(), stored));
+    REQUIRE(stored == fingerprint);
+    REQUIRE(appended.filter_params_.min_overlap_length == 500);
+    REQUIRE(appended.load(&second[0], true));
+    REQUIRE(appended.loadStats().bytes == file.size() - first_size);
+    requireSameGraph(full, appended);
+
+    // Extended fingerprint equals the one of both files.
+    ulong both;
+    REQUIRE(GraphCache::fingerprint({first.c_str(), second.c_str()}, both));
+    REQUIRE(GraphCache::extendFingerprint({second.c_str()}, stored));
+    REQUIRE(stored == both);
+
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+    std::remove(snapshot.c_str());
+    rmdir(dir);
+}
+
+TEST_CASE("Sharded graph loading") {
+    MappedFile file(PAF_FILE);
+    REQUIRE(file.valid());
+    OverlapGraph whole;
+    setDefaultFilter(whole);
+    REQUIRE(whole.load(PAF_FILE, true));
+
+    // Shards split at line boundaries, one of them empty and one compressed.
+    char dir[] = "/tmp/telomeri_shards_XXXXXX";
+    REQUIRE(mkdtemp(dir));
+    const int shards_num = 5;
+    std::vector<std::string> paths;
+    const char *cur = file.data(), *end = file.data() + file.size();
+    for (int i = 0; i < shards_num; i++) {
+        const char *shard_end = end;
+        if (i == 1) {
+            shard_end = cur;
+        } else if (i < shards_num - 1) {
+            shard_end = static_cast<const char *>(std::memchr(cur + file.size() / shards_num, '\n', end - cur)) + 1;
+        }
+        paths.push_back(std::string(dir) + "/shard_" + std::to_string(i) + ".paf" + (i == 2 ? ".gz" : ""));
+        if (i == 2) {
+            gzFile gz = gzopen(paths.back().c_str(), "wb");
+            REQUIRE(gzwrite(gz, cur, static_cast<unsigned>(shard_end - cur)) == shard_end - cur);
+            gzclose(gz);
+        } else {
+            std::ofstream(paths.back(), std::ios::binary).write(cur, shard_end - cur);
+        }
+        cur = shard_end;
+    }
+    std::ofstream(std::string(dir) + "/shards.txt") << paths[0] << '\n' << paths[1] << '\n' << paths[2] << '\n'
+                                                    << paths[3] << '\n' << paths[4] << '\n';
+
+    std::vector<std::string> globbed, listed;
+    REQUIRE(OverlapGraph::expandShards((std::string(dir) + "/shard_*").c_str(), globbed));
+    REQUIRE(globbed == paths);
+    REQUIRE(OverlapGraph::expandShards(("@" + std::string(dir) + "/shards.txt").c_str(), listed));
+    REQUIRE(listed == paths);
+    REQUIRE_FALSE(OverlapGraph::expandShards((std::string(dir) + "/missing_*").c_str(), listed));
+
+    // Concurrent shards give the same graph as the whole file.
+    for (uint threads : {1u, 2u, 4u}) {
+        OverlapGraph g;
+        setDefaultFilter(g);
+        g.load_threads_ = threads;
+        REQUIRE(g.load(globbed, true));
+        requireSameGraph(whole, g);
+        REQUIRE(g.load_stats_.size() == shards_num);
+        REQUIRE(g.loadStats().bytes == file.size());
+        REQUIRE(g.loadStats().lines == whole.loadStats().lines);
+        REQUIRE(g.load_stats_[1].lines == 0);
+    }
+
+    // A broken shard fails the whole load.
+    std::ofstream(paths[3], std::ios::binary | std::ios::app) << "broken\tline\n";
+    OverlapGraph broken;
+    setDefaultFilter(broken);
+    broken.load_threads_ = 2;
+    REQUIRE_FALSE(broken.load(paths, true));
+
+    for (const std::string &path : paths) {
+        std::remove(path.c_str());
+    }
+    std::remove((std::string(dir) + "/shards.txt").c_str());
+    rmdir(dir);
+}
+
+TEST_CASE("Loader throughput", "[.][benchmark]") {
+    const double bytes = MappedFile(PAF_FILE).size();
+
+    // Reject everything so only reading and tokenizing is measured.
+    for (OverlapGraph::LoaderMode mode : {OverlapGraph::ISTREAM, OverlapGraph::MMAP}) {
+        OverlapGraph g;
+        setDefaultFilter(g);
+        g.filter_params_.min_overlap_length = ULONG_MAX;
+        g.loader_mode_ = mode;
+
+        Stopwatch timer;
+        timer.start();
+        const int repeats = 20;
+        for (int i = 0; i < repeats; i++) {
+            REQUIRE(g.load(PAF_FILE, true));
+        }
+        double time = timer.stop();
+        std::cout << (mode == OverlapGraph::MMAP ? "mmap" : "istream") << ": "
+                  << repeats * bytes / 1e9 / time << " GB/s" << std::endl;
+    }
+}
+
+TEST_CASE("Tokenizer throughput", "[.][benchmark]") {
+    // Bundled file replicated to TELOMERI_BENCH_BYTES (default 1 GB).
+    const char *env = std::getenv("TELOMERI_BENCH_BYTES");
+    size_t size = env ? std::strtoul(env, nullptr, 10) : 1000000000ul;
+    MappedFile file(PAF_FILE);
+    REQUIRE(file.valid());
+    std::vector<char> data;
+    data.reserve(size + file.size());
+    while (data.size() < size) {
+        data.insert(data.end(), file.data(), file.data() + file.size());
+    }
+
+    // Blocks as large as the loader uses, so offsets fit into 32 bits.
+    const size_t block = 256 << 10;
+    std::vector<uint32_t> out(block);
+    auto measure = [&](const char *name, auto &&scan) {
+        Stopwatch timer;
+        timer.start();
+        size_t delimiters = 0;
+        for (size_t pos = 0; pos < data.size(); pos += block) {
+            delimiters += scan(data.data() + pos, std::min(block, data.size() - pos), out.data());
+        }
+        double time = timer.stop();
+        std::cout << name << ": " << data.size() / 1e9 / time << " GB/s (" << delimiters << " delimiters)"
+                  << std::endl;
+    };
+
+    // Newline memchr, then tab memchr within the line.
+    measure("memchr", [](const char *p, size_t n, uint32_t *o) {
+        size_t count = 0;
+        const char *cur = p, *end = p + n;
+        while (cur < end) {
+            const char *nl = static_cast<const char *>(std::memchr(cur, '\n', end - cur));
+            const char *line_end = nl ? nl : end;
+            const char *tab;
+            while ((tab = static_cast<const char *>(std::memchr(cur, '\t', line_end - cur)))) {
+                o[count++] = static_cast<uint32_t>(tab - p);
+                cur = tab + 1;
+            }
+            if (nl) {
+                o[count++] = static_cast<uint32_t>(nl - p);
+            }
+            cur = line_end + 1;
+        }
+        return count;
+    });
+    for (PAFTokenizer::Kernel kernel : {PAFTokenizer::SCALAR, PAFTokenizer::SSE2, PAFTokenizer::AVX2}) {
+        if (PAFTokenizer::supported(kernel)) {
+            const char *names[] = {"scalar", "sse2", "avx2"};
+            measure(names[kernel], [kernel](const char *p, size_t n, uint32_t *o) {
+                return PAFTokenizer::scan(p, n, o, kernel);
+            });
+        }
+    }
+}
+
+TEST_CASE("Load time scaling with read count", "[.][benchmark]") {
+    for (int reads = 25000; reads <= 400000; reads *= 2) {
+        // Chain of reads, each overlapping the next three.
+        char path[] = "/tmp/telomeri_scaling_XXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE(fd >= 0);
+        close(fd);
+        {
+            std::ofstream out(path);
+            for (int i = 0; i + 3 < reads; i++) {
+                for (int j = 1; j <= 3; j++) {
+                    out << "read" << i + j << "\t10000\t0\t" << 10000 - j * 2000 << "\t+\t"
+                        << "read" << i << "\t10000\t" << j * 2000 << "\t10000\t"
+                        << 10000 - j * 2000 << '\t' << 10000 - j * 2000 << "\t0\n";
+                }
+            }
+        }
+
+        OverlapGraph g;
+        setDefaultFilter(g);
+        Stopwatch timer;
+        timer.start();
+        REQUIRE(g.load(path, false));
+        double time = timer.stop();
+        std::remove(path);
+
+        std::cout << reads << " reads: " << time << " s, "
+                  << time / g.edgesNum() * 1e9 << " ns/edge" << std::endl;
+    }
+}
+
+/** Sums the metric over the edges of every node, repeated, the way a Monte
+ * Carlo step weighs its candidates. */
+template<typename F>
+__attribute__((noinline)) static double sumMetric(const OverlapGraph &g, int repeats, F metric) {
+    double sum = 0;
+    for (int r = 0; r < repeats; r++) {
+        for (const OverlapGraph::Node &n : g.nodes_) {
+            for (const OverlapGraph::Edge &e : g.edges(n)) {
+                sum += metric(e);
+            }
+        }
+    }
+    return sum;
+}
+
+TEST_CASE("Metric kernels") {
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(PAF_FILE, true));
+    for (Utils::Metrics metric : {Utils::Metrics::EXTENSION_SCORE, Utils::Metrics::EXTENSION_SCORE_SQRT,
+                                  Utils::Metrics::OVERLAP_SCORE, Utils::Metrics::OVERLAP_SCORE_SQRT}) {
+        Utils::dispatchMetric(metric, [&](auto m) {
+            for (const OverlapGraph::Edge &e : g.adjacency_) {
+                REQUIRE(Utils::getMetric<decltype(m)::value>(e) == Utils::getMetric(e, metric));
+            }
+        });
+    }
+}
+
+TEST_CASE("Metric kernel throughput", "[.][benchmark]") {
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(PAF_FILE, true));
+    const int repeats = 2000;
+    const double steps = static_cast<double>(repeats) * g.adjacency_.size();
+
+    for (Utils::Metrics metric : {Utils::Metrics::EXTENSION_SCORE, Utils::Metrics::EXTENSION_SCORE_SQRT,
+                                  Utils::Metrics::OVERLAP_SCORE, Utils::Metrics::OVERLAP_SCORE_SQRT}) {
+        // The metric comes from the command line, so keep the compiler from
+        // unswitching the runtime loop on a known constant.
+        volatile int runtime_choice = static_cast<int>(metric);
+        const Utils::Metrics runtime_metric = static_cast<Utils::Metrics>(runtime_choice);
+
+        Stopwatch timer;
+        timer.start();
+        double runtime_sum = sumMetric(g, repeats, [runtime_metric](const OverlapGraph::Edge &e) {
+            return Utils::getMetric(e, runtime_metric);
+        });
+        double runtime_time = timer.lap();
+        double templated_sum;
+        Utils::dispatchMetric(metric, [&](auto m) {
+            templated_sum = sumMetric(g, repeats, [](const OverlapGraph::Edge &e) {
+                return Utils::getMetric<decltype(m)::value>(e);
+            });
+        });
+        double templated_time = timer.lap();
+        REQUIRE(runtime_sum == templated_sum);
+
+        std::cout << Utils::getMetricName(metric) << ": switch " << runtime_time / steps * 1e9
+                  << " ns/step, templated " << templated_time / steps * 1e9 << " ns/step" << std::endl;
+    }
+}
+
+/** Returns the node with most edges. */
+static const OverlapGraph::Node &maxDegreeNode(const OverlapGraph &g) {
+    return *std::max_element(g.nodes_.begin(), g.nodes_.end(),
+                             [&](const OverlapGraph::Node &a, const OverlapGraph::Node &b) {
+                                 return g.edges(a).size() < g.edges(b).size();
+                             });
+}
+
+TEST_CASE("Edge sampling") {
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(PAF_FILE, true));
+    const OverlapGraph::Node &n = maxDegreeNode(g);
+    OverlapGraph::EdgeRange edges = g.edges(n);
+    REQUIRE(edges.size() > 2);
+
+    EdgeSampler sampler(g, Utils::Metrics::OVERLAP_SCORE);
+    RandomStream gen(0, 0, 0);
+    VisitedSet visited(g.nodes_.size());
+    visited.insert(n.index);
+    ulong scans = 0;
+
+    SECTION("Frequencies follow the metric") {
+        double total = 0;
+        for (const OverlapGraph::Edge &e : edges) {
+            total += e.overlap_score;
+        }
+        const int draws = 200000;
+        std::vector<int> counts(edges.size(), 0);
+        for (int i = 0; i < draws; i++) {
+            const OverlapGraph::Edge *e = sampler.sample(n, visited, gen, scans);
+            REQUIRE(e);
+            counts[e - edges.begin()]++;
+        }
+        for (size_t i = 0; i < edges.size(); i++) {
+            double expected = edges[i].overlap_score / total;
+            REQUIRE(std::abs(counts[i] / static_cast<double>(draws) - expected) < 0.01);
+        }
+        REQUIRE(scans == 0);
+    }
+
+    SECTION("Visited neighbours are never selected") {
+        for (size_t i = 1; i < edges.size(); i++) {
+            visited.insert(edges[i].q_index);
+        }
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(sampler.sample(n, visited, gen, scans) == &edges[0]);
+        }
+        visited.insert(edges[0].q_index);
+        REQUIRE(sampler.sample(n, visited, gen, scans) == nullptr);
+        REQUIRE(scans > 0);
+    }
+}
+
+TEST_CASE("Edge sampling throughput", "[.][benchmark]") {
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(PAF_FILE, true));
+    const OverlapGraph::Node &n = maxDegreeNode(g);
+    OverlapGraph::EdgeRange edges = g.edges(n);
+    const int steps = 1000000;
+
+    EdgeSampler sampler(g, Utils::Metrics::EXTENSION_SCORE);
+    RandomStream gen(0, 0, 0);
+    std::uniform_real_distribution<> dis(0., 1.);
+    VisitedSet visited(g.nodes_.size());
+    visited.insert(n.index);
+    ulong checksum = 0, scans = 0;
+
+    Stopwatch timer;
+    timer.start();
+    for (int s = 0; s < steps; s++) {
+        // Sum and search, as every Monte Carlo step did before the alias tables.
+        double sum = 0;
+        for (const OverlapGraph::Edge &e : edges) {
+            if (!visited[e.q_index]) {
+                sum += Utils::getMetric<Utils::Metrics::EXTENSION_SCORE>(e);
+            }
+        }
+        double random = dis(gen) * sum;
+        sum = 0;
+        for (const OverlapGraph::Edge &e : edges) {
+            if (!visited[e.q_index]) {
+                sum += Utils::getMetric<Utils::Metrics::EXTENSION_SCORE>(e);
+                if (sum >= random) {
+                    checksum += e.q_index;
+                    break;
+                }
+            }
+        }
+    }
+    double scan_time = timer.lap();
+    for (int s = 0; s < steps; s++) {
+        checksum += sampler.sample(n, visited, gen, scans)->q_index;
+    }
+    double alias_time = timer.lap();
+
+    std::cout << "Degree " << edges.size() << ": scan " << scan_time / steps * 1e9
+              << " ns/step, alias " << alias_time / steps * 1e9 << " ns/step (checksum " << checksum << ")"
+              << std::endl;
+}
+
+TEST_CASE("Edge order") {
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(PAF_FILE, true));
+    EdgeOrder order(g, Utils::Metrics::EXTENSION_SCORE);
+
+    for (const OverlapGraph::Node &n : g.nodes_) {
+        OverlapGraph::EdgeRange edges = g.edges(n);
+        std::vector<OverlapGraph::Edge> sorted(edges.begin(), edges.end());
+        std::stable_sort(sorted.begin(), sorted.end(), [](const OverlapGraph::Edge &a, const OverlapGraph::Edge &b) {
+            return a.extension_score > b.extension_score;
+        });
+
+        const OverlapGraph::Edge *const *ranked = order.ranked(n);
+        for (size_t i = 0; i < sorted.size(); i++) {
+            // Ranked neighbours match the sort, each through its first edge.
+            REQUIRE(ranked[i]->q_index == sorted[i].q_index);
+            const OverlapGraph::Edge *first = std::find_if(edges.begin(), edges.end(), [&](const OverlapGraph::Edge &e) {
+                return e.q_index == sorted[i].q_index;
+            });
+            REQUIRE(ranked[i] == first);
+        }
+    }
+}
+
+TEST_CASE("Anchor edge index") {
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(PAF_FILE, true));
+
+    size_t touching = 0;
+    for (const OverlapGraph::Node &n : g.nodes_) {
+        std::vector<const OverlapGraph::Edge *> expected;
+        for (const OverlapGraph::Edge &e : g.edges(n)) {
+            if (g.nodes_[e.q_index].anchor) {
+                expected.push_back(&e);
+            }
+        }
+        std::vector<const OverlapGraph::Edge *> indexed;
+        for (ulong k : g.anchorEdges(n)) {
+            indexed.push_back(&g.adjacency_[k]);
+        }
+        REQUIRE(indexed == expected);
+        REQUIRE(n.touches_anchor == !expected.empty());
+        touching += n.touches_anchor;
+    }
+    REQUIRE(touching > 0);
+    REQUIRE(touching < g.nodes_.size());
+}
+
+/** Writes read-read and contig-read overlaps of reads tiled over a genome
+ * with a contig at each end, so that reads connect the two contigs. Reads
+ * start at least read_step apart, a long step leaves few distinct paths. */
+static void writeTiledOverlaps(const std::string &rr_path, const std::string &cr_path, int read_step = 300) {
+    const int genome_len = 60000, read_len = 6000, contig_len = 20000;
+    std::mt19937 rng(11);
+    std::vector<std::pair<int, std::string>> reads;
+    for (int pos = 0, i = 0; pos + read_len <= genome_len; pos += read_step + static_cast<int>(rng() % 400), i++) {
+        reads.emplace_back(pos, "read" + std::to_string(i));
+    }
+    std::vector<std::pair<int, std::string>> contigs = {{0, "ctg0"}, {genome_len - contig_len, "ctg1"}};
+
+    // Coordinates run against the genome, the direction the walkers measure positive lengths in.
+    auto overlap = [&](std::ostream &s, int a, int a_len, const std::string &a_name,
+                       int b, int b_len, const std::string &b_name) {
+        int begin = std::max(a, b), end = std::min(a + a_len, b + b_len);
+        if (end - begin < 500) {
+            return;
+        }
+        s << a_name << '\t' << a_len << '\t' << a + a_len - end << '\t' << a + a_len - begin << "\t+\t"
+          << b_name << '\t' << b_len << '\t' << b + b_len - end << '\t' << b + b_len - begin << '\t'
+          << (end - begin) * 9 / 10 << '\t' << end - begin << "\t60\n";
+    };
+    std::ofstream rr(rr_path), cr(cr_path);
+    for (size_t i = 0; i < reads.size(); i++) {
+        for (size_t j = i + 1; j < reads.size(); j++) {
+            overlap(rr, reads[i].first, read_len, reads[i].second, reads[j].first, read_len, reads[j].second);
+        }
+        for (const auto &c : contigs) {
+            overlap(cr, c.first, contig_len, c.second, reads[i].first, read_len, reads[i].second);
+        }
+    }
+}
+
+/** Returns paths of the manager as node and edge indices, in order. */
+static std::vector<std::vector<size_t>> pathIndices(PathManager &pm, const OverlapGraph &g) {
+    std::vector<std::vector<size_t>> indices;
+    for (const auto &anchors_paths : pm.getPathsBetweenAnchors()) {
+        for (const Path *p : anchors_paths.second) {
+            indices.emplace_back();
+            for (const OverlapGraph::Node *n : p->nodes_) {
+                indices.back().push_back(n->index);
+            }
+            for (const OverlapGraph::Edge *e : p->edges_) {
+                indices.back().push_back(e - g.adjacency_.data());
+            }
+        }
+    }
+    return indices;
+}
+
+TEST_CASE("Parallel path construction") {
+    char dir[] = "/tmp/telomeri_paths_XXXXXX";
+    REQUIRE(mkdtemp(dir));
+    std::string rr_path = std::string(dir) + "/rr.paf", cr_path = std::string(dir) + "/cr.paf";
+    writeTiledOverlaps(rr_path, cr_path);
+    OverlapGraph g;
+    setDefaultFilter(g);
+    REQUIRE(g.load(rr_path.c_str(), false));
+    REQUIRE(g.load(cr_path.c_str(), true));
+
+    auto build = [&](uint threads, ulong seed, bool monte_carlo) {
+        PathManager pm;
+        pm.params_ = {150, 60, 4700000l, 1000ul, 0.9f, seed, threads};
+        if (monte_carlo) {
+            pm.buildMonteCarlo(g, Utils::Metrics::EXTENSION_SCORE);
+        } else {
+            pm.buildDeterministic(g, Utils::Metrics::OVERLAP_SCORE);
+        }
+        return pathIndices(pm, g);
+    };
+    std::vector<std::vector<size_t>> monte_carlo = build(1, 7, true);
+    REQUIRE(!monte_carlo.empty());
+    REQUIRE(build(3, 7, true) == monte_carlo);
+    REQUIRE(build(8, 7, true) == monte_carlo);
+    REQUIRE(build(1, 8, true) != monte_carlo);
+
+
+    std::vector<std::vector<size_t>> deterministic = build(1, 7, false);
+    REQUIRE(!deterministic.empty());
+    REQUIRE(build(3, 7, false) == deterministic);
+    REQUIRE(build(8, 7, false) == deterministic);
+
+    // Reads that barely overlap leave few paths, so attempts repeat them.
+    // Duplicates of the previous attempt are dropped while walking, even
+    // when attempts are split between workers.
+    writeTiledOverlaps(rr_path, cr_path, 2500);
+    OverlapGraph sparse;
+    setDefaultFilter(sparse);
+    REQUIRE(sparse.load(rr_path.c_str(), false));
+    REQUIRE(sparse.load(cr_path.c_str(), true));
+    std::vector<std::vector<size_t>> unique;
+    for (uint threads : {1u, 3u}) {
+        PathManager pm;
+        pm.params_ = {150, 60, 4700000l, 1000ul, 0.9f, 7, threads};
+        pm.buildMonteCarlo(sparse, Utils::Metrics::EXTENSION_SCORE);
+        std::vector<std::vector<size_t>> found = pathIndices(pm, sparse);
+        REQUIRE(!found.empty());
+        pm.filterUnique();
+        REQUIRE(pathIndices(pm, sparse) == found);
+        REQUIRE((unique.empty() || found == unique));
+        unique = found;
+    }
+
+    std::remove(rr_path.c_str());
+    std::remove(cr_path.c_str());
+    rmdir(dir);
+}
+
+TEST_CASE("Task scheduler") {
+    SECTION("Every step runs once") {
+        std::vector<uint> steps = {0, 1, 1000, 7, 300, 0, 64};
+        std::vector<std::unique_ptr<std::atomic<int>[]>> runs;
+        for (uint n : steps) {
+            runs.emplace_back(new std::atomic<int>[n]());
+        }
+        for (uint threads : {1u, 2u, 5u}) {
+            for (size_t t = 0; t < steps.size(); t++) {
+                std::fill(runs[t].get(), runs[t].get() + steps[t], 0);
+            }
+            TaskScheduler scheduler(threads);
+            std::atomic<bool> bad_worker{false};
+            scheduler.run(steps, [&](size_t task, uint step, uint worker) {
+                // Assertions are not thread-safe, check them after the run.
+                bad_worker = bad_worker || worker >= threads;
+                runs[task][step]++;
+            });
+            REQUIRE_FALSE(bad_worker);
+            for (size_t t = 0; t < steps.size(); t++) {
+                REQUIRE(std::all_of(runs[t].get(), runs[t].get() + steps[t], [](const std::atomic<int> &r) {
+                    return r == 1;
+                }));
+            }
+            REQUIRE(scheduler.busyTimes().size() == threads);
+        }
+    }
+
+    SECTION("Tasks larger than a range are split") {
+        // Steps of a split task keep their numbering across its parts.
+        const uint n = TaskScheduler::MAX_STEPS + 5;
+        TaskScheduler scheduler(3);
+        std::atomic<ulong> count{0}, sum{0};
+        scheduler.run({n, 2}, [&](size_t task, uint step, uint) {
+            if (task == 0) {
+                count++;
+                sum += step;
+            }
+        });
+        REQUIRE(count == n);
+        REQUIRE(sum == (ulong) n * (n - 1) / 2);
+    }
+
+    SECTION("Idle workers steal from a slow task") {
+        // One task keeps the first worker busy, the others can only steal.
+        TaskScheduler scheduler(4);
+        std::atomic<int> done{0};
+        scheduler.run({64}, [&](size_t, uint, uint) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            done++;
+        });
+        REQUIRE(done == 64);
+        REQUIRE(scheduler.steals() > 0);
+        for (double busy : scheduler.busyTimes()) {
+            REQUIRE(busy > 0);
+        }
+    }
+}
+
+TEST_CASE("Visited set") {
+    VisitedSet visited(10);
+    visited.insert(3);
+    visited.insert(7);
+    visited.erase(7);
+    REQUIRE(visited[3]);
+    REQUIRE_FALSE(visited[7]);
+    REQUIRE_FALSE(visited[0]);
+
+    // Every clear starts a new generation.
+    for (size_t i = 0; i < 3; i++) {
+        visited.clear();
+        for (size_t n = 0; n < visited.size(); n++) {
+            REQUIRE_FALSE(visited[n]);
+        }
+        visited.insert(i);
+        REQUIRE(visited[i]);
+    }
+
+    // A stamp left from before the generation wraps around is not visited.
+    visited.insert(5);
+    for (size_t i = 0; i < 65536; i++) {
+        visited.clear();
+        REQUIRE_FALSE(visited[5]);
+    }
+}
+
+TEST_CASE("Incremental path length") {
+    std::vector<OverlapGraph::Node> nodes;
+    std::vector<OverlapGraph::Edge> edges;
+    for (uint i = 0; i < 6; i++) {
+        nodes.emplace_back(i == 0, i, 1000 + i);
+        edges.emplace_back(i + 1, 100 * i + 700, 1000, 50 * i, 300, 0.5f, 0.9f, 0.5f, false);
+    }
+
+    // Length after every push and pop matches the one recomputed from scratch.
+    auto requireLength = [](const Path &p) {
+        Path copy = p;
+        copy.updateLength();
+        REQUIRE(p.length() == copy.length());
+    };
+    Path p;
+    p.start(&nodes[0]);
+    requireLength(p);
+    REQUIRE(p.length() == 1000);
+    for (uint i = 0; i < 5; i++) {
+        p.push(&edges[i], &nodes[i + 1]);
+        requireLength(p);
+    }
+    for (uint i = 0; i < 3; i++) {
+        p.pop();
+        requireLength(p);
+    }
+    p.push(&edges[5], &nodes[5]);
+    requireLength(p);
+    REQUIRE(p.nodes_.size() == p.edges_.size() + 1);
 }